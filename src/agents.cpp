@@ -0,0 +1,85 @@
+#include "agents.h"
+
+#include <climits>
+#include <random>
+
+AgentPlanner::AgentPlanner(const int threads): m_pool(threads), m_graph(nullptr), m_algorithm(Search::DIJKSTRA), m_rows(0), m_cols(0) {}
+
+void AgentPlanner::plan(const Graph &graph, const Search::Algorithm algorithm, const vector<Agent> &agents, vector<AgentPlan> *plans) {
+
+    if(m_graph != &graph || m_algorithm != algorithm || m_rows != graph.getRows() || m_cols != graph.getCols()) {
+        m_searches.clear();
+        m_searches.resize(m_pool.getWorkerCount());
+        m_graph = &graph;
+        m_algorithm = algorithm;
+        m_rows = graph.getRows();
+        m_cols = graph.getCols();
+    }
+
+    plans->resize(agents.size());
+
+    // a single search is long enough that splitting down to one agent pays off
+    m_pool.parallelFor(agents.size(), 1, [&](const int worker, const size_t i) {
+
+        const Agent &agent = agents[i];
+        std::unique_ptr<Search> &search = m_searches[worker];
+
+        if(search) search->restart(agent.start, agent.target);
+        else search = std::make_unique<Search>(graph, algorithm, agent.start, agent.target);
+
+        while(!search->step(INT_MAX, nullptr, nullptr));
+
+        AgentPlan &plan = (*plans)[i];
+        plan.found = search->hasPath();
+        plan.expansions = search->getExpansions();
+        search->getPath(&plan.path);
+
+    });
+
+}
+
+int AgentPlanner::getThreadCount() const {
+    return m_pool.getWorkerCount();
+}
+
+size_t AgentPlanner::getMemoryUsage() const {
+
+    size_t bytes = 0;
+    for(const auto &search : m_searches) if(search) bytes += search->getMemoryUsage();
+
+    return bytes;
+
+}
+
+void followFlowField(const FlowField &field, const vector<Agent> &agents, vector<AgentPlan> *plans) {
+
+    plans->resize(agents.size());
+
+    for(size_t i = 0; i < agents.size(); i++) {
+
+        AgentPlan &plan = (*plans)[i];
+        plan.path.clear();
+        if(agents[i].target == field.getTarget()) plan.path = field.getPath(agents[i].start);
+
+        plan.found = !plan.path.empty();
+        plan.expansions = 0;
+
+    }
+
+}
+
+void randomAgents(const Graph &graph, const int count, const uint32_t seed, vector<Agent> *agents) {
+
+    std::mt19937 random = std::mt19937(seed);
+    std::uniform_int_distribution<int> col = std::uniform_int_distribution<int>(0, graph.getCols() - 1);
+    std::uniform_int_distribution<int> row = std::uniform_int_distribution<int>(0, graph.getRows() - 1);
+
+    agents->clear();
+
+    for(auto i = 0; i < count; i++) {
+        Graph::Node start = Graph::Node(col(random), row(random), graph.getCols());
+        Graph::Node target = Graph::Node(col(random), row(random), graph.getCols());
+        agents->push_back(Agent { start, target });
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef AGENTS_H
+#define AGENTS_H
+
+#include "flowfield.h"
+#include "graph.h"
+#include "search.h"
+#include "threadpool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using std::vector;
+
+struct Agent {
+    Graph::Node start;
+    Graph::Node target;
+};
+
+struct AgentPlan {
+    bool found;
+    int expansions;
+    vector<Graph::Node> path;
+};
+
+// Plans many agents at once, each independently of the others. The graph
+// is only read while planning, so all workers share it without locking;
+// every worker keeps its own Search between calls and restarts it per
+// agent instead of allocating fresh per-cell buffers.
+class AgentPlanner {
+
+public:
+    // 0 threads picks one per hardware thread
+    AgentPlanner(const int threads);
+
+    // plans[i] receives the path for agents[i]; the graph must not change until this returns
+    void plan(const Graph &graph, const Search::Algorithm algorithm, const vector<Agent> &agents, vector<AgentPlan> *plans);
+
+    int getThreadCount() const;
+    // the per-worker searches, the plans belong to the caller
+    size_t getMemoryUsage() const;
+
+private:
+    WorkStealingPool m_pool;
+
+    // one per worker, rebuilt when the graph or the algorithm changes
+    vector<std::unique_ptr<Search>> m_searches;
+    const Graph *m_graph;
+    Search::Algorithm m_algorithm;
+    int m_rows;
+    int m_cols;
+
+};
+
+// agents sharing the field's target follow it instead of searching; plans
+// of agents with another target come back empty
+void followFlowField(const FlowField &field, const vector<Agent> &agents, vector<AgentPlan> *plans);
+
+// count agents with uniformly random start and target cells
+void randomAgents(const Graph &graph, const int count, const uint32_t seed, vector<Agent> *agents);
+
+#endif
@@ -0,0 +1,237 @@
+#include "anyangle.h"
+#include "topology.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+bool hasLineOfSight(const Graph &graph, const Graph::Node from, const Graph::Node to) {
+
+    int nx = std::abs(to.x - from.x);
+    int ny = std::abs(to.y - from.y);
+    int x = from.x;
+    int y = from.y;
+
+    // directions of travel, indices of FourConnected::isOpen
+    int horizontal = to.x < from.x ? 0 : 2;
+    int vertical = to.y < from.y ? 1 : 3;
+    int sx = to.x < from.x ? -1 : 1;
+    int sy = to.y < from.y ? -1 : 1;
+
+    for(int ix = 0, iy = 0; ix < nx || iy < ny;) {
+
+        // which grid line the line crosses next, compared in integers: the
+        // vertical one at (ix + 0.5) / nx or the horizontal one at (iy + 0.5) / ny
+        int64_t decision = (int64_t) (1 + 2 * ix) * ny - (int64_t) (1 + 2 * iy) * nx;
+
+        if(decision == 0) {
+
+            if(!FourConnected::isOpen(graph, x, y, horizontal) || !FourConnected::isOpen(graph, x + sx, y, vertical)) return false;
+            if(!FourConnected::isOpen(graph, x, y, vertical) || !FourConnected::isOpen(graph, x, y + sy, horizontal)) return false;
+
+            x += sx;
+            y += sy;
+            ix++;
+            iy++;
+
+        } else if(decision < 0) {
+
+            if(!FourConnected::isOpen(graph, x, y, horizontal)) return false;
+            x += sx;
+            ix++;
+
+        } else {
+
+            if(!FourConnected::isOpen(graph, x, y, vertical)) return false;
+            y += sy;
+            iy++;
+
+        }
+
+    }
+
+    return true;
+
+}
+
+void pullString(const Graph &graph, const vector<Graph::Node> &path, vector<Graph::Node> *waypoints) {
+
+    waypoints->clear();
+    if(path.empty()) return;
+
+    Graph::Node anchor = path.front();
+    waypoints->push_back(anchor);
+
+    // a node is a corner once the line from the last corner cannot reach past it
+    for(size_t i = 1; i < path.size(); i++) {
+
+        if(i + 1 < path.size() && hasLineOfSight(graph, anchor, path[i + 1])) continue;
+
+        anchor = path[i];
+        waypoints->push_back(anchor);
+
+    }
+
+}
+
+double getPolylineLength(const vector<Graph::Node> &waypoints) {
+
+    double length = 0;
+    for(size_t i = 1; i < waypoints.size(); i++) length += std::hypot(waypoints[i].x - waypoints[i - 1].x, waypoints[i].y - waypoints[i - 1].y);
+
+    return length;
+
+}
+
+ThetaStar::ThetaStar(const Graph &graph, const Variant variant):
+    m_graph(graph), m_variant(variant), m_cols(graph.getCols()), m_expansions(0), m_lineOfSightChecks(0), m_pathCost(-1), m_generation(0) {}
+
+bool ThetaStar::findPath(const Graph::Node start, const Graph::Node target, vector<Graph::Node> *waypoints) {
+
+    waypoints->clear();
+
+    size_t cells = (size_t) m_graph.getRows() * m_graph.getCols();
+
+    // the graph may have been resized since the last query
+    if(m_cells.size() != cells || m_cols != m_graph.getCols()) {
+        m_cells.assign(cells, CellRecord { 0, INT_MAX, -1, false });
+        m_cols = m_graph.getCols();
+        m_generation = 0;
+    }
+
+    if(++m_generation == 0) {
+        std::fill(m_cells.begin(), m_cells.end(), CellRecord { 0, INT_MAX, -1, false });
+        m_generation = 1;
+    }
+
+    m_open.clear();
+    m_expansions = 0;
+    m_lineOfSightChecks = 0;
+    m_pathCost = -1;
+
+    if(cells == 0) return false;
+
+    EightConnected<false> neighborhood = EightConnected<false>(m_graph);
+
+    CellRecord &first = getRecord(start.id);
+    first.distance = 0;
+    first.parent = start.id;
+    m_open.push_back(std::make_pair(getCost(start.id, target.id), start.id));
+
+    while(!m_open.empty()) {
+
+        std::pop_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+        int id = m_open.back().second;
+        m_open.pop_back();
+
+        CellRecord &record = m_cells[id];
+        if(record.closed) continue;
+
+        // the lazy variant only now checks the parent it assumed, falling
+        // back to the best expanded neighbour; one always exists, the
+        // neighbour the assumption was made from
+        if(m_variant == LAZY && record.parent != id && !hasLineOfSight(record.parent, id)) {
+
+            record.distance = INT_MAX;
+
+            neighborhood.forEachNeighbor(id, [&](const int neighbor, const int) {
+
+                const CellRecord &previous = getRecord(neighbor);
+                if(!previous.closed) return;
+
+                int distance = previous.distance + getCost(neighbor, id);
+
+                if(distance < record.distance) {
+                    record.distance = distance;
+                    record.parent = neighbor;
+                }
+
+            });
+
+        }
+
+        record.closed = true;
+        m_expansions++;
+
+        if(id == target.id) break;
+
+        int parent = record.parent;
+
+        neighborhood.forEachNeighbor(id, [&](const int neighbor, const int) {
+
+            CellRecord &next = getRecord(neighbor);
+            if(next.closed) return;
+
+            // through the expanded node's parent if it sees the neighbour, else through the node itself
+            int from = m_variant == LAZY || hasLineOfSight(parent, neighbor) ? parent : id;
+            int distance = m_cells[from].distance + getCost(from, neighbor);
+            if(distance >= next.distance) return;
+
+            next.distance = distance;
+            next.parent = from;
+            m_open.push_back(std::make_pair(distance + getCost(neighbor, target.id), neighbor));
+            std::push_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+
+        });
+
+    }
+
+    if(!getRecord(target.id).closed) return false;
+
+    m_pathCost = m_cells[target.id].distance;
+
+    for(int id = target.id; ; id = m_cells[id].parent) {
+        waypoints->push_back(Graph::Node(id % m_cols, id / m_cols, m_cols));
+        if(id == start.id) break;
+    }
+
+    std::reverse(waypoints->begin(), waypoints->end());
+
+    return true;
+
+}
+
+int ThetaStar::getExpansions() const {
+    return m_expansions;
+}
+
+int ThetaStar::getLineOfSightChecks() const {
+    return m_lineOfSightChecks;
+}
+
+double ThetaStar::getPathCost() const {
+    return m_pathCost < 0 ? -1.0 : (double) m_pathCost / ANY_ANGLE_COST_SCALE;
+}
+
+size_t ThetaStar::getMemoryUsage() const {
+    return getCapacityBytes(m_open) + getCapacityBytes(m_cells);
+}
+
+ThetaStar::CellRecord &ThetaStar::getRecord(const int id) {
+
+    CellRecord &record = m_cells[id];
+    if(record.generation != m_generation) record = CellRecord { m_generation, INT_MAX, -1, false };
+
+    return record;
+
+}
+
+// straight line distance, also the heuristic; rounding down keeps it admissible
+int ThetaStar::getCost(const int from, const int to) const {
+
+    int dx = from % m_cols - to % m_cols;
+    int dy = from / m_cols - to / m_cols;
+
+    return (int) (std::sqrt((double) dx * dx + (double) dy * dy) * ANY_ANGLE_COST_SCALE);
+
+}
+
+bool ThetaStar::hasLineOfSight(const int from, const int to) {
+
+    m_lineOfSightChecks++;
+
+    return ::hasLineOfSight(m_graph, Graph::Node(from % m_cols, from / m_cols, m_cols), Graph::Node(to % m_cols, to / m_cols, m_cols));
+
+}
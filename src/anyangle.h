@@ -0,0 +1,83 @@
+#ifndef ANYANGLE_H
+#define ANYANGLE_H
+
+#include "graph.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+// distances of the any-angle search are fixed point, this many units per cell width
+#define ANY_ANGLE_COST_SCALE 1024
+
+// Whether a straight line between two cell centres stays inside open
+// passages. The line is walked cell by cell (supercover), so it sees every
+// cell it touches; where it passes exactly through a grid corner both ways
+// around that corner have to be open, the same rule 8-connected moves
+// without corner cutting follow.
+bool hasLineOfSight(const Graph &graph, const Graph::Node from, const Graph::Node to);
+
+// String pulling: shortens a path of neighbouring cells from any search
+// into the waypoints where it has to turn, keeping every leg in line of
+// sight. The first and last node are always kept.
+void pullString(const Graph &graph, const vector<Graph::Node> &path, vector<Graph::Node> *waypoints);
+
+// euclidean length of a waypoint list, in cell widths
+double getPolylineLength(const vector<Graph::Node> &waypoints);
+
+// Theta* over a Graph: A* on 8-connected moves without corner cutting
+// whose nodes may take any cell in line of sight as parent, so paths run
+// at any angle. The lazy variant assumes line of sight when relaxing and
+// only checks it once a node is expanded, which saves most of the checks.
+class ThetaStar {
+
+public:
+    enum Variant {
+        EAGER,
+        LAZY
+    };
+
+    ThetaStar(const Graph &graph, const Variant variant);
+
+    // runs a whole query; waypoints receives the corners of the path from
+    // start to target, or nothing if there is no path
+    bool findPath(const Graph::Node start, const Graph::Node target, vector<Graph::Node> *waypoints);
+
+    int getExpansions() const;
+    int getLineOfSightChecks() const;
+    // the last path's length in cell widths, -1 without one
+    double getPathCost() const;
+    size_t getMemoryUsage() const;
+
+private:
+    typedef std::pair<int, int> QueueEntry;
+
+    struct CellRecord {
+        uint32_t generation;
+        int distance;
+        int parent;
+        bool closed;
+    };
+
+    inline CellRecord &getRecord(const int id);
+    int getCost(const int from, const int to) const;
+    bool hasLineOfSight(const int from, const int to);
+
+    const Graph &m_graph;
+    Variant m_variant;
+    int m_cols;
+    int m_expansions;
+    int m_lineOfSightChecks;
+    int m_pathCost;
+
+    TrackedVector<QueueEntry, MEMORY_SEARCH> m_open;
+    TrackedVector<CellRecord, MEMORY_SEARCH> m_cells;
+    uint32_t m_generation;
+
+};
+
+#endif
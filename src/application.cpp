@@ -1,6 +1,24 @@
 #include "application.h"
+#include "agents.h"
+#include "anyangle.h"
+#include "camera.h"
+#include "edits.h"
+#include "flowfield.h"
 #include "glad/glad.h"
 #include "graph.h"
+#include "heatmap.h"
+#include "lod.h"
+#include "maze.h"
+#include "mazefile.h"
+#include "memory.h"
+#include "movingai.h"
+#include "pacer.h"
+#include "profiler.h"
+#include "race.h"
+#include "search.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "walls.h"
 
 #define IM_VEC2_CLASS_EXTRA friend bool operator==(const ImVec2 &a, const ImVec2 &b) {return a.x == b.x && a.y == b.y; }
 
@@ -9,43 +27,211 @@
 #include "backends/imgui_impl_opengl3.h"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <GLFW/glfw3.h>
 #include <memory>
+#include <random>
 #include <iostream>
 #include <utility>
 
 #define TILE_BORDER_COLOR IM_COL32(150, 150, 150, 150)
 #define BLACK IM_COL32(0, 0, 0, 255)
 #define WHITE IM_COL32(255, 255, 255, 255)
+#define PATH_COLOR IM_COL32(255, 200, 0, 255)
+#define ANY_ANGLE_COLOR IM_COL32(0, 140, 255, 255)
+
+// tile borders are skipped once they would cover most of the tile
+#define MIN_TILE_BORDER_SIZE 4.0f
+#define ZOOM_STEP 1.2f
+
+// trace recording and replay, set from the controls window and driven by the main loop
+struct TraceState {
+    char path[256];
+    bool record;
+    bool openRequested;
+    bool replaying;
+    bool playing;
+    float eventsPerSecond;
+    double position;
+    const char *status;
+    TracePlayer player;
+};
+
+// multi-agent planning, requested from the controls window and run by the main loop
+struct AgentState {
+    int count;
+    int algorithm;
+    int rows;
+    int cols;
+    bool sharedTarget;
+    bool planRequested;
+    bool clearRequested;
+    double planMs;
+    vector<Agent> agents;
+    vector<AgentPlan> plans;
+};
+
+// shared flow field towards the target, requested from the controls window and kept up to date by the main loop
+struct FlowState {
+    bool computeRequested;
+    bool clearRequested;
+    bool showOverlay;
+    double updateMs;
+};
+
+// algorithms raced against a snapshot of the graph, started from the controls window and polled by the main loop;
+// each lane's visited cells are counted into a coarse grid of bins for its small view
+struct RaceState {
+    bool selected[Search::ALGORITHM_COUNT];
+    bool startRequested;
+    bool stopRequested;
+    bool showWindow;
+    uint64_t version;
+    int rows;
+    int cols;
+    int binRows;
+    int binCols;
+    vector<vector<int>> bins;
+    vector<vector<Graph::Node>> paths;
+};
+
+#define RACE_VIEW_BINS 64
+#define RACE_VIEW_HEIGHT 160.0f
+#define RACE_VISITED_COLOR IM_COL32(80, 140, 255, 255)
+
+// arrows need a few pixels per tile to be readable
+#define FLOW_ARROW_TILE_SIZE 8.0f
+
+// below this tile size individual walls turn into aliasing noise and the
+// LOD pyramid is drawn instead
+#define LOD_TILE_SIZE 3.0f
+#define LOD_MIN_TEXEL_SIZE 4.0f
+
+#define EDIT_JOURNAL_BUDGET (64 * 1024 * 1024)
+
+#define BRUSH_FREEHAND 0
+#define BRUSH_RECTANGLE 1
+
+// entries of the any-angle combo
+#define ANY_ANGLE_OFF 0
+#define ANY_ANGLE_PULL 1
+#define ANY_ANGLE_THETA 2
+#define ANY_ANGLE_LAZY_THETA 3
 
 #define NODE_NULL Graph::Node(-1, -1, 0)
 
-template <typename T>
-bool vectorHasElement(vector<T> vec, T el) {
-    return std::find(vec.begin(), vec.end(), el) != vec.end();
-}
-
 std::pair<Graph::Node, Graph::Node> toBeConnected = std::make_pair<Graph::Node, Graph::Node>(NODE_NULL, NODE_NULL);
 
-Graph::Node getNodeUnderMouse(const ImVec2 mousePos, const ImVec2 gridUpperLeft, const ImVec2 gridBottomRight, float tileSize, int *cols) {
+Graph::Node getNodeUnderMouse(const ImVec2 mousePos, const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const Camera &camera, int *rows, int *cols) {
+
+    if(mousePos.x < viewportUpperLeft.x || mousePos.x > viewportBottomRight.x || mousePos.y < viewportUpperLeft.y || mousePos.y > viewportBottomRight.y) return NODE_NULL;
+
+    ImVec2 worldPos = camera.screenToWorld(mousePos);
+    ImVec2 tileCoordinates = ImVec2(std::floor(worldPos.x), std::floor(worldPos.y));
 
-    if(mousePos.x < gridUpperLeft.x || mousePos.x > gridBottomRight.x || mousePos.y < gridUpperLeft.y || mousePos.y > gridBottomRight.y) return NODE_NULL;
+    if(tileCoordinates.x < 0 || tileCoordinates.y < 0 || tileCoordinates.x >= *cols || tileCoordinates.y >= *rows) return NODE_NULL;
 
-    ImVec2 tileCoordinates = ImVec2(std::floor((mousePos.x - gridUpperLeft.x) / tileSize), std::floor((mousePos.y - gridUpperLeft.y) / tileSize));
     Graph::Node nodeUnderMouse = Graph::Node(tileCoordinates.x, tileCoordinates.y, *cols);
 
     return nodeUnderMouse;
 
 }
 
-void handleLeftMouseButton(const std::shared_ptr<Graph> graph, const ImVec2 gridUpperLeft, const ImVec2 gridBottomRight, const float tileSize, int *cols) {
+// converts a world coordinate to a cell index clamped to [0, max]
+int clampToGrid(const float value, const int max) {
+    return (int) std::clamp(value, 0.0f, (float) max);
+}
+
+void handleCameraInput(Camera *camera, const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight) {
+
+    ImGuiIO &io = ImGui::GetIO();
+    if(io.WantCaptureMouse) return;
+
+    ImVec2 mousePos = ImGui::GetMousePos();
+    if(mousePos.x < viewportUpperLeft.x || mousePos.x > viewportBottomRight.x || mousePos.y < viewportUpperLeft.y || mousePos.y > viewportBottomRight.y) return;
+
+    if(ImGui::IsMouseDown(ImGuiMouseButton_Middle)) camera->pan(io.MouseDelta);
+    if(io.MouseWheel != 0.0f) camera->zoomAt(mousePos, std::pow(ZOOM_STEP, io.MouseWheel));
+
+}
+
+void drawWallRuns(ImDrawList *drawList, const Walls &walls, const Camera &camera, const int firstRow, const int lastRow, const int firstCol, const int lastCol) {
+
+    const auto &horizontalRuns = walls.getHorizontalRuns();
+    const auto &verticalRuns = walls.getVerticalRuns();
+
+    for(auto y = std::max(firstRow, 1); y <= std::min(lastRow, (int) horizontalRuns.size() - 2); y++) {
+
+        const Walls::SegmentList &runs = horizontalRuns[y];
+        auto it = std::partition_point(runs.begin(), runs.end(), [firstCol](const Walls::Segment &segment) { return segment.x1 <= firstCol; });
+
+        for(; it != runs.end() && it->x0 < lastCol; it++) {
+            drawList->AddLine(camera.worldToScreen(ImVec2(std::max(it->x0, firstCol), y)), camera.worldToScreen(ImVec2(std::min(it->x1, lastCol), y)), BLACK, 3.0f);
+        }
+
+    }
+
+    for(auto x = std::max(firstCol, 1); x <= std::min(lastCol, (int) verticalRuns.size() - 2); x++) {
+
+        const Walls::SegmentList &runs = verticalRuns[x];
+        auto it = std::partition_point(runs.begin(), runs.end(), [firstRow](const Walls::Segment &segment) { return segment.y1 <= firstRow; });
+
+        for(; it != runs.end() && it->y0 < lastRow; it++) {
+            drawList->AddLine(camera.worldToScreen(ImVec2(x, std::max(it->y0, firstRow))), camera.worldToScreen(ImVec2(x, std::min(it->y1, lastRow))), BLACK, 3.0f);
+        }
+
+    }
+
+}
+
+void drawLod(ImDrawList *drawList, const LodPyramid &lod, const Camera &camera, const int firstRow, const int lastRow, const int firstCol, const int lastCol) {
+
+    int level = lod.chooseLevel(camera.getTileSize(), LOD_MIN_TEXEL_SIZE);
+    int shift = lod.getBlockShift(level);
+
+    int firstTexelCol = firstCol >> shift;
+    int firstTexelRow = firstRow >> shift;
+    int lastTexelCol = std::min((lastCol + (1 << shift) - 1) >> shift, lod.getLevelCols(level));
+    int lastTexelRow = std::min((lastRow + (1 << shift) - 1) >> shift, lod.getLevelRows(level));
+
+    for(auto row = firstTexelRow; row < lastTexelRow; row++) {
+
+        for(auto col = firstTexelCol; col < lastTexelCol; col++) {
+
+            float path = lod.getDensity(LodPyramid::PATH, level, col, row);
+            float visited = lod.getDensity(LodPyramid::VISITED, level, col, row);
+            float wallDensity = 1.0f - lod.getDensity(LodPyramid::PASSAGES, level, col, row);
+
+            ImColor texelColor;
+            if(path > 0.0f) texelColor = ImColor(1.0f, 0.85f, 0.0f);
+            else if(visited > 0.0f) texelColor = ImColor(0.5f, 0.7f + 0.3f * visited, 1.0f);
+            else if(wallDensity > 0.0f) texelColor = ImColor(1.0f - wallDensity, 1.0f - wallDensity, 1.0f - wallDensity);
+            else continue;
+
+            ImVec2 texelUpperLeft = camera.worldToScreen(ImVec2(col << shift, row << shift));
+            ImVec2 texelBottomRight = camera.worldToScreen(ImVec2((col + 1) << shift, (row + 1) << shift));
+
+            drawList->AddRectFilled(texelUpperLeft, texelBottomRight, texelColor);
+
+        }
+
+    }
+
+}
+
+void handleLeftMouseButton(EditBuffer *edits, const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const Camera &camera, int *rows, int *cols) {
 
-    if(!ImGui::IsMouseDown(ImGuiMouseButton_Left)) return;
+    // a new stroke must not connect to where the previous one ended
+    if(!ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        toBeConnected.first = NODE_NULL;
+        return;
+    }
 
     ImVec2 mousePos = ImGui::GetMousePos();
 
-    Graph::Node nodeUnderMouse = getNodeUnderMouse(mousePos, gridUpperLeft, gridBottomRight, tileSize, cols);
+    Graph::Node nodeUnderMouse = getNodeUnderMouse(mousePos, viewportUpperLeft, viewportBottomRight, camera, rows, cols);
     if(nodeUnderMouse == NODE_NULL) return;
 
     if(toBeConnected.first == NODE_NULL) {
@@ -57,31 +243,363 @@ void handleLeftMouseButton(const std::shared_ptr<Graph> graph, const ImVec2 grid
 
     toBeConnected.second = nodeUnderMouse;
 
-    // tiles are diagonally aligned; not next to each other
-    if(std::abs(toBeConnected.first.x - toBeConnected.second.x) + std::abs(toBeConnected.first.y - toBeConnected.second.y) > 1) {
-        toBeConnected.first = toBeConnected.second;
+    // cells skipped by a fast drag are filled in along a line
+    edits->connectLine(toBeConnected.first, toBeConnected.second);
+    toBeConnected.first = toBeConnected.second;
+
+}
+
+void handleRightMouseButton(EditBuffer *edits, const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const Camera &camera, int *rows, int *cols) {
+
+    static Graph::Node lastIsolated = NODE_NULL;
+
+    if(!ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
+        lastIsolated = NODE_NULL;
         return;
     }
 
-    graph->addEdge(toBeConnected.first, toBeConnected.second);
-    toBeConnected.first = toBeConnected.second;
+    ImVec2 mousePos = ImGui::GetMousePos();
+
+    Graph::Node nodeUnderMouse = getNodeUnderMouse(mousePos, viewportUpperLeft, viewportBottomRight, camera, rows, cols);
+    if(nodeUnderMouse == NODE_NULL || nodeUnderMouse == lastIsolated) return;
+
+    edits->isolateLine(lastIsolated == NODE_NULL ? nodeUnderMouse : lastIsolated, nodeUnderMouse);
+    lastIsolated = nodeUnderMouse;
 
 }
 
-void handleRightMouseButton(const std::shared_ptr<Graph> graph, const ImVec2 gridUpperLeft, const ImVec2 gridBottomRight, const float tileSize, int *cols) {
+// left drag clears a rectangular room, right drag fills it with walls
+void handleRectangleBrush(EditBuffer *edits, ImDrawList *drawList, const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const Camera &camera, int *rows, int *cols) {
 
-    if(!ImGui::IsMouseDown(ImGuiMouseButton_Right)) return;
+    static Graph::Node anchor = NODE_NULL;
+    static Graph::Node corner = NODE_NULL;
+    static ImGuiMouseButton button = ImGuiMouseButton_Left;
 
     ImVec2 mousePos = ImGui::GetMousePos();
+    Graph::Node nodeUnderMouse = getNodeUnderMouse(mousePos, viewportUpperLeft, viewportBottomRight, camera, rows, cols);
 
-    Graph::Node nodeUnderMouse = getNodeUnderMouse(mousePos, gridUpperLeft, gridBottomRight, tileSize, cols);
-    if(nodeUnderMouse == NODE_NULL) return;
+    if(anchor == NODE_NULL) {
+
+        if(nodeUnderMouse == NODE_NULL) return;
+
+        for(ImGuiMouseButton candidate : { ImGuiMouseButton_Left, ImGuiMouseButton_Right }) {
+            if(!ImGui::IsMouseClicked(candidate)) continue;
+            anchor = nodeUnderMouse;
+            corner = nodeUnderMouse;
+            button = candidate;
+        }
+
+        return;
+
+    }
+
+    if(nodeUnderMouse != NODE_NULL) corner = nodeUnderMouse;
+
+    if(ImGui::IsMouseDown(button)) {
+
+        ImVec2 upperLeft = camera.worldToScreen(ImVec2(std::min(anchor.x, corner.x), std::min(anchor.y, corner.y)));
+        ImVec2 bottomRight = camera.worldToScreen(ImVec2(std::max(anchor.x, corner.x) + 1, std::max(anchor.y, corner.y) + 1));
+        drawList->AddRect(upperLeft, bottomRight, button == ImGuiMouseButton_Left ? PATH_COLOR : BLACK, 0, 0, 2.0f);
+
+        return;
+
+    }
+
+    if(button == ImGuiMouseButton_Left) edits->clearRect(anchor, corner);
+    else edits->fillRect(anchor, corner);
+
+    anchor = NODE_NULL;
+
+}
+
+// keeps the derived caches in sync with a batch of applied edits
+void applyEdits(const AppliedEdits &applied, const Graph &graph, Walls *walls, LodPyramid *lod) {
+
+    int cols = graph.getCols();
+
+    for(const CellDelta &delta : applied.cells) {
+
+        Graph::Node node = Graph::Node(delta.cell % cols, delta.cell / cols, cols);
+        walls->invalidate(node);
+
+        uint8_t changed = delta.before ^ delta.after;
+
+        if(changed & Graph::RIGHT) {
+            int sign = delta.after & Graph::RIGHT ? 1 : -1;
+            lod->add(LodPyramid::PASSAGES, node.x, node.y, sign);
+            lod->add(LodPyramid::PASSAGES, node.x + 1, node.y, sign);
+        }
+
+        if(changed & Graph::DOWN) {
+            int sign = delta.after & Graph::DOWN ? 1 : -1;
+            lod->add(LodPyramid::PASSAGES, node.x, node.y, sign);
+            lod->add(LodPyramid::PASSAGES, node.x, node.y + 1, sign);
+        }
+
+    }
+
+    for(const EditRegion &region : applied.regions) {
+        walls->invalidateRect(region.x0, region.y0, region.x1, region.y1);
+        lod->refresh(graph, region.x0, region.y0, region.x1, region.y1);
+    }
+
+}
+
+// mirrors the cell changes of a replay step into the heatmap and the visited channel of the LOD pyramid
+void applyTraceChanges(const vector<TraceChange> &changes, const int cols, Heatmap *heatmap, LodPyramid *lod) {
+
+    for(const TraceChange &change : changes) {
+
+        int x = change.cell % cols;
+        int y = change.cell / cols;
+
+        if(change.after == Search::VISITED) heatmap->setVisited(x, y, change.distance);
+        else if(change.after == Search::FRONTIER) heatmap->setFrontier(x, y);
+        else heatmap->setUnseen(x, y);
+
+        if(change.after == Search::VISITED) lod->add(LodPyramid::VISITED, x, y, 1);
+        if(change.before == Search::VISITED) lod->add(LodPyramid::VISITED, x, y, -1);
+
+    }
+
+}
+
+// tints cells by their distance to the target and, once tiles are large enough, points an arrow along each direction
+void drawFlowField(ImDrawList *backgroundDrawList, ImDrawList *foregroundDrawList, const FlowField &field, const Camera &camera, const int firstRow, const int lastRow, const int firstCol, const int lastCol) {
+
+    float tileSize = camera.getTileSize();
+    float maxDistance = std::max(1, field.getMaxDistance());
+    const ImVec2 arrowTips[4] = { ImVec2(-0.3f, 0.0f), ImVec2(0.0f, -0.3f), ImVec2(0.3f, 0.0f), ImVec2(0.0f, 0.3f) };
+
+    for(auto y = firstRow; y < lastRow; y++) {
+        for(auto x = firstCol; x < lastCol; x++) {
+
+            Graph::Node node = Graph::Node(x, y, field.getCols());
+            int distance = field.getDistance(node);
+            if(distance < 0) continue;
+
+            float t = distance / maxDistance;
+            backgroundDrawList->AddRectFilled(camera.worldToScreen(ImVec2(x, y)), camera.worldToScreen(ImVec2(x + 1, y + 1)), ImColor(0.2f + 0.8f * t, 0.6f, 1.0f - 0.8f * t, 0.35f));
+
+            FlowField::Direction direction = field.getDirection(node);
+            if(tileSize < FLOW_ARROW_TILE_SIZE || direction == FlowField::NONE) continue;
+
+            ImVec2 center = ImVec2(x + 0.5f, y + 0.5f);
+            ImVec2 tip = ImVec2(center.x + arrowTips[direction].x, center.y + arrowTips[direction].y);
+            foregroundDrawList->AddLine(camera.worldToScreen(ImVec2(center.x - arrowTips[direction].x, center.y - arrowTips[direction].y)), camera.worldToScreen(tip), BLACK, 1.0f);
+            foregroundDrawList->AddCircleFilled(camera.worldToScreen(tip), std::max(1.5f, tileSize * 0.08f), BLACK);
+
+        }
+    }
+
+}
+
+// every agent gets its own hue, spread by the golden ratio so neighbouring indices differ
+void drawAgents(ImDrawList *drawList, const vector<Agent> &agents, const vector<AgentPlan> &plans, const Camera &camera, const float tileSize) {
 
-    graph->removeAllNeighbors(nodeUnderMouse);
+    vector<ImVec2> points;
+
+    for(size_t i = 0; i < plans.size(); i++) {
+
+        ImU32 color = ImColor::HSV(std::fmod(i * 0.618034f, 1.0f), 0.8f, 0.9f);
+        const Agent &agent = agents[i];
+
+        points.clear();
+        for(const Graph::Node &node : plans[i].path) points.push_back(camera.worldToScreen(ImVec2(node.x + 0.5f, node.y + 0.5f)));
+        drawList->AddPolyline(points.data(), points.size(), color, 0, std::max(1.0f, tileSize * 0.1f));
+
+        drawList->AddRectFilled(camera.worldToScreen(ImVec2(agent.start.x + 0.25f, agent.start.y + 0.25f)), camera.worldToScreen(ImVec2(agent.start.x + 0.75f, agent.start.y + 0.75f)), color);
+        drawList->AddRect(camera.worldToScreen(ImVec2(agent.target.x + 0.25f, agent.target.y + 0.25f)), camera.worldToScreen(ImVec2(agent.target.x + 0.75f, agent.target.y + 0.75f)), color, 0, 0, 2.0f);
+
+    }
+
+}
+
+// heap bytes held by one live object, listed in the memory panel
+struct MemoryFootprint {
+    const char *name;
+    size_t bytes;
+};
+
+double toMegabytes(const size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+void showProfilerWindow(const Profiler &profiler) {
+
+    ImGui::Begin("Profiler");
+
+    std::vector<Profiler::FrameSample> samples = profiler.getSamples();
+    std::array<Profiler::Percentiles, Profiler::PHASE_COUNT + 1> summary = profiler.summarize();
+
+    ImGui::Text("Frame: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms", summary[Profiler::PHASE_COUNT].p50, summary[Profiler::PHASE_COUNT].p95, summary[Profiler::PHASE_COUNT].p99);
+
+    const ImU32 phaseColors[Profiler::PHASE_COUNT] = {
+        IM_COL32(90, 160, 230, 255),
+        IM_COL32(230, 160, 60, 255),
+        IM_COL32(110, 200, 110, 255),
+        IM_COL32(200, 90, 200, 255),
+        IM_COL32(230, 220, 80, 255),
+        IM_COL32(220, 80, 80, 255),
+        IM_COL32(160, 160, 160, 255)
+    };
+
+    // flame-style bar of the most recent frame, one segment per phase
+    if(!samples.empty()) {
+
+        const Profiler::FrameSample &latest = samples.back();
+
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        ImVec2 barUpperLeft = ImGui::GetCursorScreenPos();
+        ImVec2 barSize = ImVec2(ImGui::GetContentRegionAvail().x, 20.0f);
+        float x = barUpperLeft.x;
+
+        for(auto phase = 0; phase < Profiler::PHASE_COUNT; phase++) {
+
+            float segmentWidth = latest.totalMs > 0.0f ? barSize.x * latest.phaseMs[phase] / latest.totalMs : 0.0f;
+            drawList->AddRectFilled(ImVec2(x, barUpperLeft.y), ImVec2(x + segmentWidth, barUpperLeft.y + barSize.y), phaseColors[phase]);
+            x += segmentWidth;
+
+        }
+
+        ImGui::Dummy(barSize);
+
+    }
+
+    if(ImGui::BeginTable("phases", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("p50 (ms)");
+        ImGui::TableSetupColumn("p95 (ms)");
+        ImGui::TableSetupColumn("p99 (ms)");
+        ImGui::TableHeadersRow();
+
+        for(auto phase = 0; phase < Profiler::PHASE_COUNT; phase++) {
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImColor(phaseColors[phase]), "%s", Profiler::getPhaseName((Profiler::Phase) phase));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary[phase].p50);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary[phase].p95);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary[phase].p99);
+
+        }
+
+        ImGui::EndTable();
+
+    }
+
+    static const char *dumpStatus = "";
+
+    if(ImGui::Button("Dump CSV")) {
+        dumpStatus = profiler.dumpCsv("profile.csv") ? "Wrote profile.csv" : "Failed to write profile.csv";
+    }
+
+    ImGui::SameLine();
+    ImGui::Text("%s", dumpStatus);
+
+    ImGui::End();
+
+}
+
+void showRaceWindow(const AlgorithmRace &race, const RaceState &state, const uint64_t latestVersion, bool *open) {
+
+    ImGui::Begin("Race", open);
+
+    if(race.getLaneCount() > 0) ImGui::Text("Graph version %llu, latest %llu", (unsigned long long) state.version, (unsigned long long) latestVersion);
+
+    size_t laneCount = std::min(race.getLaneCount(), state.bins.size());
+
+    // one view per lane side by side, all on the same scale so the visited areas compare directly
+    if(laneCount > 0) {
+
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        float spacing = ImGui::GetStyle().ItemSpacing.x;
+        float laneWidth = (ImGui::GetContentRegionAvail().x - spacing * (laneCount - 1)) / laneCount;
+        float scale = std::min(laneWidth / state.cols, RACE_VIEW_HEIGHT / state.rows);
+        ImVec2 viewSize = ImVec2(state.cols * scale, state.rows * scale);
+        float binWidth = viewSize.x / state.binCols;
+        float binHeight = viewSize.y / state.binRows;
+        float cellsPerBin = (float) state.rows * state.cols / (state.binRows * state.binCols);
+
+        for(size_t lane = 0; lane < laneCount; lane++) {
+
+            if(lane > 0) ImGui::SameLine();
+
+            ImGui::BeginGroup();
+            ImGui::Text("%s", Search::getAlgorithmName(race.getStatus(lane).algorithm));
+
+            ImVec2 upperLeft = ImGui::GetCursorScreenPos();
+            drawList->AddRectFilled(upperLeft, ImVec2(upperLeft.x + viewSize.x, upperLeft.y + viewSize.y), WHITE);
+
+            for(auto row = 0; row < state.binRows; row++) {
+                for(auto col = 0; col < state.binCols; col++) {
+
+                    int count = state.bins[lane][row * state.binCols + col];
+                    if(count == 0) continue;
+
+                    ImColor color = ImColor(RACE_VISITED_COLOR);
+                    color.Value.w = std::min(1.0f, 0.2f + 0.8f * count / cellsPerBin);
+
+                    ImVec2 binUpperLeft = ImVec2(upperLeft.x + col * binWidth, upperLeft.y + row * binHeight);
+                    drawList->AddRectFilled(binUpperLeft, ImVec2(binUpperLeft.x + binWidth, binUpperLeft.y + binHeight), color);
+
+                }
+            }
+
+            vector<ImVec2> pathPoints;
+            for(const Graph::Node &node : state.paths[lane]) pathPoints.push_back(ImVec2(upperLeft.x + (node.x + 0.5f) * scale, upperLeft.y + (node.y + 0.5f) * scale));
+            drawList->AddPolyline(pathPoints.data(), pathPoints.size(), PATH_COLOR, 0, 2.0f);
+
+            drawList->AddRect(upperLeft, ImVec2(upperLeft.x + viewSize.x, upperLeft.y + viewSize.y), BLACK);
+            ImGui::Dummy(ImVec2(laneWidth, viewSize.y));
+            ImGui::EndGroup();
+
+        }
+
+    }
+
+    if(ImGui::BeginTable("lanes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+
+        ImGui::TableSetupColumn("Algorithm");
+        ImGui::TableSetupColumn("Wall (ms)");
+        ImGui::TableSetupColumn("Expansions");
+        ImGui::TableSetupColumn("Peak (MB)");
+        ImGui::TableSetupColumn("Path cost");
+        ImGui::TableHeadersRow();
+
+        for(size_t lane = 0; lane < race.getLaneCount(); lane++) {
+
+            RaceStatus status = race.getStatus(lane);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", Search::getAlgorithmName(status.algorithm));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", status.wallMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", status.expansions);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", toMegabytes(status.peakBytes));
+            ImGui::TableNextColumn();
+            if(!status.finished) ImGui::TextDisabled(race.isRunning() ? "running" : "stopped");
+            else if(status.found) ImGui::Text("%.1f", status.pathCost);
+            else ImGui::TextDisabled("no path");
+
+        }
+
+        ImGui::EndTable();
+
+    }
+
+    ImGui::End();
 
 }
 
-void showControlsWindow(const std::shared_ptr<Graph> graph, int *rows, int *cols, ImVec2 *startPos, ImVec2 *targetPos) {
+void showControlsWindow(const std::shared_ptr<Graph> graph, int *rows, int *cols, ImVec2 *startPos, ImVec2 *targetPos, bool *resetView, bool *showProfiler, FramePacer *pacer, int *runAlgorithm, int *expansionsPerFrame, bool *showHeatmap, const bool heatmapSupported, const Search *search, EditJournal *journal, int *historyStep, int *brushMode, bool *graphReplaced, TraceState *trace, AgentState *agents, const int threadCount, FlowState *flow, const FlowField &flowField, int *topology, int *anyAngle, const vector<Graph::Node> &waypoints, const vector<MemoryFootprint> &footprints, RaceState *race, const bool raceRunning) {
 
     ImGui::Begin("Controls");
 
@@ -108,16 +626,29 @@ void showControlsWindow(const std::shared_ptr<Graph> graph, int *rows, int *cols
 
         }
 
-        ImGui::Button("Generate Maze");
+        if(ImGui::Button("Generate Maze")) {
+
+            // the combo entries follow the order of MazeAlgorithm after the placeholder
+            for(int i = 1; i < IM_ARRAYSIZE(mazeGenerationAlgorithms); i++) {
+
+                if(currentMaze != mazeGenerationAlgorithms[i]) continue;
+
+                generateMaze(graph.get(), (MazeAlgorithm) (i - 1), std::random_device()());
+                *graphReplaced = true;
+                journal->clear();
+
+            }
+
+        }
 
     }
 
     if(ImGui::CollapsingHeader("Pathfinding")) {
 
-        const char *pathfindingAlgorithms[] = { "Select Algorithm", "Dijkstras" };
+        const char *pathfindingAlgorithms[] = { "Select Algorithm", "Dijkstra", "A*", "BFS", "Jump Point Search" };
         static const char *currentPathfindingAlgo = pathfindingAlgorithms[0];
 
-        if(ImGui::BeginCombo("##combo", currentPathfindingAlgo)) {
+        if(ImGui::BeginCombo("##pathfinding", currentPathfindingAlgo)) {
 
             for(int i = 0; i < IM_ARRAYSIZE(pathfindingAlgorithms); i++) {
 
@@ -135,29 +666,353 @@ void showControlsWindow(const std::shared_ptr<Graph> graph, int *rows, int *cols
 
         }
 
-        ImGui::Button("Run Algorithm");
+        if(ImGui::Button("Run Algorithm")) {
+
+            // the combo entries follow the order of Search::Algorithm after the placeholder
+            for(int i = 1; i < IM_ARRAYSIZE(pathfindingAlgorithms); i++) {
+                if(currentPathfindingAlgo == pathfindingAlgorithms[i]) *runAlgorithm = i - 1;
+            }
+
+        }
+
+        // the square topologies, in the order of Topology
+        const char *topologies[] = { "4-connected", "8-connected", "8-connected, no corner cutting" };
+        ImGui::Combo("Movement", topology, topologies, IM_ARRAYSIZE(topologies));
+
+        const char *anyAngleModes[] = { "Grid path", "String pulling", "Theta*", "Lazy Theta*" };
+        ImGui::Combo("Any-angle", anyAngle, anyAngleModes, IM_ARRAYSIZE(anyAngleModes));
+
+        ImGui::SliderInt("Expansions / Frame", expansionsPerFrame, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Show Heatmap", showHeatmap);
+        if(*showHeatmap && !heatmapSupported) ImGui::TextDisabled("Grid exceeds the GPU texture size, no heatmap");
+
+        if(search) {
+            ImGui::Text("Expanded: %d", search->getExpansions());
+            if(search->isFinished() && search->hasPath()) ImGui::Text("Path length: %d (cost %.1f)", search->getPathLength(), search->getPathCost());
+            else if(search->isFinished()) ImGui::Text("No path found");
+            if(!waypoints.empty()) ImGui::Text("Any-angle length: %.1f (%zu waypoints)", getPolylineLength(waypoints), waypoints.size());
+        }
+
+        ImGui::Separator();
+
+        // the combo entries after the placeholder, in the order of Search::Algorithm
+        for(int i = 0; i < Search::ALGORITHM_COUNT; i++) {
+            if(i > 0) ImGui::SameLine();
+            ImGui::Checkbox(pathfindingAlgorithms[i + 1], &race->selected[i]);
+        }
+
+        if(ImGui::Button("Race Selected")) race->startRequested = true;
+        ImGui::SameLine();
+        if(ImGui::Button("Stop Race")) race->stopRequested = true;
+        ImGui::SameLine();
+        ImGui::Checkbox("Show Race", &race->showWindow);
+
+        if(raceRunning) ImGui::TextDisabled("Racing on a snapshot, edits apply to the next race");
+
+    }
+
+    if(ImGui::CollapsingHeader("Agents")) {
+
+        const char *algorithmNames[Search::ALGORITHM_COUNT];
+        for(int i = 0; i < Search::ALGORITHM_COUNT; i++) algorithmNames[i] = Search::getAlgorithmName((Search::Algorithm) i);
+
+        ImGui::Checkbox("Shared target (flow field)", &agents->sharedTarget);
+        if(!agents->sharedTarget) ImGui::Combo("##agents", &agents->algorithm, algorithmNames, Search::ALGORITHM_COUNT);
+        ImGui::SliderInt("Agents", &agents->count, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic);
+
+        if(ImGui::Button("Plan Agents")) agents->planRequested = true;
+        ImGui::SameLine();
+        if(ImGui::Button("Clear Agents")) agents->clearRequested = true;
+
+        if(!agents->plans.empty()) ImGui::Text("%zu agents on %d threads in %.2f ms", agents->plans.size(), agents->sharedTarget ? 1 : threadCount, agents->planMs);
+
+    }
+
+    if(ImGui::CollapsingHeader("Flow Field")) {
+
+        if(ImGui::Button("Compute From Target")) flow->computeRequested = true;
+        ImGui::SameLine();
+        if(ImGui::Button("Clear Field")) flow->clearRequested = true;
+
+        ImGui::Checkbox("Show Overlay", &flow->showOverlay);
+
+        if(!flowField.isEmpty()) {
+            ImGui::Text("Target %d, %d", flowField.getTarget().x, flowField.getTarget().y);
+            ImGui::Text("Last update: %zu cells in %.2f ms", flowField.getRepairedCells(), flow->updateMs);
+        }
+
+    }
+
+    if(ImGui::CollapsingHeader("Trace")) {
+
+        ImGui::InputText("Trace file", trace->path, IM_ARRAYSIZE(trace->path));
+        ImGui::Checkbox("Record searches", &trace->record);
+
+        if(ImGui::Button("Open Replay")) trace->openRequested = true;
+
+        ImGui::SameLine();
+        ImGui::Text("%s", trace->status);
+
+        if(trace->replaying) {
+
+            int position = (int) trace->position;
+            if(ImGui::SliderInt("Event", &position, 0, (int) trace->player.getEventCount())) trace->position = position;
+
+            if(ImGui::Button(trace->playing ? "Pause" : "Play")) trace->playing = !trace->playing;
+            ImGui::SameLine();
+            if(ImGui::Button("Stop Replay")) trace->replaying = false;
+
+            ImGui::SliderFloat("Events / Second", &trace->eventsPerSecond, 1.0f, 10000000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+
+        }
 
     }
 
     if(ImGui::CollapsingHeader("Grid")) {
 
-        if(ImGui::SliderInt("Rows", rows, 1, 50)) {
+        if(ImGui::SliderInt("Rows", rows, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic)) {
 
             graph->resize(*rows, *cols);
             if(startPos->y >= *rows) startPos->y = *rows - 1;
             if(targetPos->y >= *rows) targetPos->y = *rows - 1; 
+            *resetView = true;
+            journal->clear();
 
         }
         
-        if(ImGui::SliderInt("Columns", cols, 1, 80)) {
+        if(ImGui::SliderInt("Columns", cols, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic)) {
 
             graph->resize(*rows, *cols);
             if(startPos->x >= *cols) startPos->x = *cols - 1;
             if(targetPos->x >= *cols) targetPos->x = *cols - 1;
+            *resetView = true;
+            journal->clear();
 
         }
 
-        
+        if(ImGui::Button("Reset View")) *resetView = true;
+        ImGui::TextDisabled("Middle mouse to pan, wheel to zoom");
+
+    }
+
+    if(ImGui::CollapsingHeader("File")) {
+
+        static char mazePath[256] = "maze.pfvm";
+        static int layout = MAZE_FILE_RLE;
+        static const char *fileStatus = "";
+
+        ImGui::InputText("Path", mazePath, IM_ARRAYSIZE(mazePath));
+        ImGui::RadioButton("Plain", &layout, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("Compressed", &layout, MAZE_FILE_RLE);
+        ImGui::SameLine();
+        ImGui::RadioButton("Mappable", &layout, MAZE_FILE_MAPPABLE);
+
+        if(ImGui::Button("Save")) {
+            fileStatus = saveMaze(*graph, mazePath, layout) ? "Saved" : "Failed to save";
+        }
+
+        ImGui::SameLine();
+
+        if(ImGui::Button("Load")) {
+
+            if(loadMaze(graph.get(), mazePath)) {
+
+                *rows = graph->getRows();
+                *cols = graph->getCols();
+                startPos->x = std::min<float>(startPos->x, *cols - 1);
+                startPos->y = std::min<float>(startPos->y, *rows - 1);
+                targetPos->x = std::min<float>(targetPos->x, *cols - 1);
+                targetPos->y = std::min<float>(targetPos->y, *rows - 1);
+                *resetView = true;
+                *graphReplaced = true;
+                journal->clear();
+                fileStatus = "Loaded";
+
+            } else {
+                fileStatus = "Failed to load";
+            }
+
+        }
+
+        ImGui::SameLine();
+        ImGui::Text("%s", fileStatus);
+
+        if(graph->isShared()) ImGui::TextDisabled("Mapped read-only, edited bands are copied");
+
+    }
+
+    if(ImGui::CollapsingHeader("Benchmark")) {
+
+        static char mapPath[256] = "";
+        static char scenarioPath[256] = "";
+        static int algorithm = Search::DIJKSTRA;
+        static vector<Scenario> scenarios;
+        static vector<ScenarioResult> results;
+        static Topology resultsTopology = FOUR_CONNECTED;
+        static const char *benchmarkStatus = "";
+
+        const char *algorithms[] = { "Dijkstra", "A*", "BFS", "Jump Point Search" };
+
+        ImGui::InputText("Map (.map)", mapPath, IM_ARRAYSIZE(mapPath));
+        ImGui::InputText("Scenarios (.scen)", scenarioPath, IM_ARRAYSIZE(scenarioPath));
+        ImGui::Combo("Algorithm", &algorithm, algorithms, IM_ARRAYSIZE(algorithms));
+
+        if(ImGui::Button("Import Map")) {
+
+            if(loadMovingAiMap(graph.get(), mapPath)) {
+
+                *rows = graph->getRows();
+                *cols = graph->getCols();
+                startPos->x = std::min<float>(startPos->x, *cols - 1);
+                startPos->y = std::min<float>(startPos->y, *rows - 1);
+                targetPos->x = std::min<float>(targetPos->x, *cols - 1);
+                targetPos->y = std::min<float>(targetPos->y, *rows - 1);
+                *resetView = true;
+                *graphReplaced = true;
+                journal->clear();
+                results.clear();
+                benchmarkStatus = "Imported map";
+
+            } else {
+                benchmarkStatus = "Failed to import map";
+            }
+
+        }
+
+        ImGui::SameLine();
+
+        // runs synchronously so the latencies are not mixed with frame work
+        if(ImGui::Button("Run Scenarios")) {
+
+            if(loadMovingAiScenarios(scenarioPath, *cols, &scenarios)) {
+                resultsTopology = (Topology) *topology;
+                runScenarios(*graph, (Search::Algorithm) algorithm, resultsTopology, scenarios, &results);
+                benchmarkStatus = "Ran scenarios";
+            } else {
+                benchmarkStatus = "Failed to read scenarios";
+            }
+
+        }
+
+        ImGui::SameLine();
+
+        if(ImGui::Button("Dump CSV##scenarios")) {
+            benchmarkStatus = dumpScenarioCsv(scenarios, results, "scenarios.csv") ? "Wrote scenarios.csv" : "Failed to write scenarios.csv";
+        }
+
+        ImGui::Text("%s", benchmarkStatus);
+
+        if(!results.empty()) {
+
+            int solved = 0;
+            double latency = 0;
+            double expansions = 0;
+            double gap = 0;
+
+            for(const ScenarioResult &result : results) {
+                if(!result.solved) continue;
+                solved++;
+                latency += result.latencyMs;
+                expansions += result.expansions;
+                gap += result.gap;
+            }
+
+            ImGui::Text("Solved: %d / %zu", solved, results.size());
+
+            if(solved > 0) {
+                ImGui::Text("Mean latency: %.3f ms", latency / solved);
+                ImGui::Text("Mean expansions: %.0f", expansions / solved);
+                ImGui::Text("Mean gap: %.2f%%", 100.0 * gap / solved);
+                ImGui::TextDisabled("%s search against octile references", getTopologyName(resultsTopology));
+            }
+
+        }
+
+    }
+
+    if(ImGui::CollapsingHeader("Edit")) {
+
+        ImGui::RadioButton("Freehand", brushMode, BRUSH_FREEHAND);
+        ImGui::SameLine();
+        ImGui::RadioButton("Rectangle", brushMode, BRUSH_RECTANGLE);
+
+        ImGui::BeginDisabled(!journal->canUndo());
+        if(ImGui::Button("Undo")) *historyStep = -1;
+        ImGui::EndDisabled();
+
+        ImGui::SameLine();
+
+        ImGui::BeginDisabled(!journal->canRedo());
+        if(ImGui::Button("Redo")) *historyStep = 1;
+        ImGui::EndDisabled();
+
+        ImGui::Text("History: %zu steps, %zu bytes", journal->getTransactionCount(), journal->getByteSize());
+        ImGui::TextDisabled("Ctrl+Z to undo, Ctrl+Y or Ctrl+Shift+Z to redo");
+
+    }
+
+    if(ImGui::CollapsingHeader("Diagnostics")) {
+        ImGui::Checkbox("Show Profiler", showProfiler);
+
+        int targetFps = pacer->getTargetFps();
+        if(ImGui::SliderInt("Target FPS", &targetFps, 10, 240)) pacer->setTargetFps(targetFps);
+
+        ImGui::Text("Redraw: %s", pacer->isIdle() ? "idle" : "continuous");
+    }
+
+    if(ImGui::CollapsingHeader("Memory")) {
+
+        MemoryStats total = getTotalMemoryStats();
+        ImGui::Text("Tracked: %.2f MB, peak %.2f MB", toMegabytes(total.currentBytes), toMegabytes(total.peakBytes));
+
+        // live counters of the tracking allocators
+        if(ImGui::BeginTable("subsystems", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+
+            ImGui::TableSetupColumn("Subsystem");
+            ImGui::TableSetupColumn("Current (MB)");
+            ImGui::TableSetupColumn("Peak (MB)");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableHeadersRow();
+
+            for(auto i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++) {
+
+                MemoryStats stats = getMemoryStats((MemorySubsystem) i);
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", getMemorySubsystemName((MemorySubsystem) i));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", toMegabytes(stats.currentBytes));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", toMegabytes(stats.peakBytes));
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", stats.allocations);
+
+            }
+
+            ImGui::EndTable();
+
+        }
+
+        // what each live object reports for itself, capacity included
+        if(ImGui::BeginTable("objects", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+
+            ImGui::TableSetupColumn("Object");
+            ImGui::TableSetupColumn("Footprint (MB)");
+            ImGui::TableHeadersRow();
+
+            for(const MemoryFootprint &footprint : footprints) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", footprint.name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", toMegabytes(footprint.bytes));
+            }
+
+            ImGui::EndTable();
+
+        }
 
     }
 
@@ -171,6 +1026,53 @@ int Application::run() {
     int cols = 60;
 
     std::shared_ptr<Graph> graph = std::make_shared<Graph>(rows, cols);
+    Walls walls = Walls(*graph);
+    LodPyramid lod = LodPyramid(*graph);
+    Camera camera = Camera();
+    bool resetView = true;
+    bool showProfiler = false;
+    Profiler profiler = Profiler();
+    FramePacer pacer = FramePacer(60);
+
+    // set while a search or maze generation is stepping; without it the
+    // loop sleeps until the next input event
+    bool animating = false;
+
+    EditBuffer edits = EditBuffer();
+    EditJournal journal = EditJournal(EDIT_JOURNAL_BUDGET);
+    AppliedEdits appliedEdits = AppliedEdits();
+    int historyStep = 0;
+    int brushMode = BRUSH_FREEHAND;
+    bool graphReplaced = false;
+    int topology = FOUR_CONNECTED;
+
+    TraceState trace = TraceState { "search.trace", false, false, false, false, 10000.0f, 0.0, "", TracePlayer() };
+    std::unique_ptr<TraceWriter> traceWriter;
+    vector<TraceChange> traceChanges;
+
+    AgentState agents = AgentState { 100, Search::DIJKSTRA, rows, cols, false, false, false, 0.0, {}, {} };
+    FlowState flow = FlowState { false, false, true, 0.0 };
+    FlowField flowField;
+    AgentPlanner planner = AgentPlanner(0);
+
+    RaceState raceState = RaceState { { true, true, true, true }, false, false, false, 0, 0, 0, 0, 0, {}, {} };
+    AlgorithmRace race;
+    vector<Graph::Node> raceNodes;
+
+    // what threads other than this one read; republished in frames that changed the graph
+    GraphVersions versions = GraphVersions(*graph);
+    bool graphEdited = false;
+
+    std::unique_ptr<Search> search;
+    vector<Graph::Node> path;
+    vector<Graph::Node> waypoints;
+    int anyAngle = ANY_ANGLE_OFF;
+    int anyAngleShown = ANY_ANGLE_OFF;
+    vector<Graph::Node> frontierNodes;
+    vector<Graph::Node> visitedNodes;
+    int runAlgorithm = -1;
+    int expansionsPerFrame = 50;
+    bool showHeatmap = true;
     ImVec2 startPos = ImVec2(0, 0);
     ImVec2 targetPos = ImVec2(cols - 1, rows - 1);
 
@@ -205,8 +1107,14 @@ int Application::run() {
 
     glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
 
+    // owns GL objects, so it lives between loading OpenGL and terminating GLFW
+    std::unique_ptr<Heatmap> heatmap = std::make_unique<Heatmap>();
+
     while(!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        profiler.beginFrame();
+        profiler.beginPhase(Profiler::EVENTS);
+
+        pacer.waitForNextFrame(animating);
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -219,67 +1127,413 @@ int Application::run() {
         // GUI STARTS HERE
         // ===============
 
-        showControlsWindow(graph, &rows, &cols, &startPos, &targetPos);
+        profiler.beginPhase(Profiler::CONTROLS);
+
+        size_t planBytes = agents.plans.capacity() * sizeof(AgentPlan);
+        for(const AgentPlan &plan : agents.plans) planBytes += plan.path.capacity() * sizeof(Graph::Node);
+
+        vector<MemoryFootprint> footprints = {
+            { "Graph", graph->getMemoryUsage() },
+            { "Search", search ? search->getMemoryUsage() : 0 },
+            { "Agent searches", planner.getMemoryUsage() },
+            { "Agent plans", planBytes },
+            { "Flow field", flowField.getMemoryUsage() },
+            { "LOD pyramid", lod.getMemoryUsage() },
+            { "Wall runs", walls.getMemoryUsage() },
+            { "Heatmap", heatmap->getMemoryUsage() },
+            { "Edit journal", journal.getMemoryUsage() },
+            { "Trace", trace.player.getMemoryUsage() + (traceWriter ? traceWriter->getMemoryUsage() : 0) }
+        };
+
+        showControlsWindow(graph, &rows, &cols, &startPos, &targetPos, &resetView, &showProfiler, &pacer, &runAlgorithm, &expansionsPerFrame, &showHeatmap, heatmap->getRows() == 0 || heatmap->isSupported(), search.get(), &journal, &historyStep, &brushMode, &graphReplaced, &trace, &agents, planner.getThreadCount(), &flow, flowField, &topology, &anyAngle, waypoints, footprints, &raceState, race.isRunning());
+        if(showProfiler) showProfilerWindow(profiler);
+        if(raceState.showWindow) showRaceWindow(race, raceState, versions.pin()->number, &raceState.showWindow);
+
+        profiler.beginPhase(Profiler::SEARCH);
+
+        // a loaded or generated maze may keep the old dimensions, so the caches cannot rely on a size change
+        if(graphReplaced) {
+            walls.rebuild(*graph);
+            lod.rebuild(*graph);
+            search.reset();
+            traceWriter.reset();
+            trace.replaying = false;
+            agents.clearRequested = true;
+            if(!flowField.isEmpty()) flow.computeRequested = true;
+            path.clear();
+            waypoints.clear();
+            graphEdited = true;
+            graphReplaced = false;
+        }
+
+        lod.update(*graph);
+
+        // a resize invalidates every node id the search holds
+        if(search && (search->getRows() != rows || search->getCols() != cols)) {
+            search.reset();
+            traceWriter.reset();
+            path.clear();
+            waypoints.clear();
+        }
+
+        if(trace.replaying && (trace.player.getRows() != rows || trace.player.getCols() != cols)) {
+            trace.replaying = false;
+            path.clear();
+            waypoints.clear();
+        }
+
+        if(runAlgorithm >= 0) {
+
+            search = std::make_unique<Search>(*graph, (Search::Algorithm) runAlgorithm, Graph::Node(startPos.x, startPos.y, cols), Graph::Node(targetPos.x, targetPos.y, cols), (Topology) topology);
+            path.clear();
+            waypoints.clear();
+            trace.replaying = false;
+
+            traceWriter.reset();
+
+            if(trace.record) {
+                traceWriter = std::make_unique<TraceWriter>();
+                bool opened = traceWriter->open(trace.path, rows, cols, Graph::Node(startPos.x, startPos.y, cols), Graph::Node(targetPos.x, targetPos.y, cols));
+                trace.status = opened ? "Recording" : "Failed to record";
+                if(opened) search->setTrace(traceWriter.get());
+                else traceWriter.reset();
+            }
+            lod.clear(LodPyramid::VISITED);
+            lod.clear(LodPyramid::PATH);
+            runAlgorithm = -1;
+
+            // the heatmap texture is only allocated once a search needs it
+            if(heatmap->getRows() != rows || heatmap->getCols() != cols) heatmap->resize(rows, cols);
+            else heatmap->clear();
+
+        }
+
+        if(search && !search->isFinished()) {
+
+            frontierNodes.clear();
+            visitedNodes.clear();
+
+            bool finished = search->step(expansionsPerFrame, &frontierNodes, &visitedNodes);
+
+            for(const Graph::Node &node : frontierNodes) heatmap->setFrontier(node.x, node.y);
+
+            for(const Graph::Node &node : visitedNodes) {
+                heatmap->setVisited(node.x, node.y, search->getDistance(node));
+                lod.add(LodPyramid::VISITED, node.x, node.y, 1);
+            }
+
+            if(finished) {
+                path = search->getPath();
+                for(const Graph::Node &node : path) lod.add(LodPyramid::PATH, node.x, node.y, 1);
+                if(traceWriter) trace.status = "Recorded";
+                traceWriter.reset();
+                anyAngleShown = ANY_ANGLE_OFF;
+            }
+
+        }
+
+        // the waypoints follow the finished path and the chosen mode; Theta* runs its own query between the same ends
+        if(search && search->isFinished() && !path.empty() && anyAngleShown != anyAngle) {
+
+            if(anyAngle == ANY_ANGLE_PULL) pullString(*graph, path, &waypoints);
+            else if(anyAngle != ANY_ANGLE_OFF) ThetaStar(*graph, anyAngle == ANY_ANGLE_LAZY_THETA ? ThetaStar::LAZY : ThetaStar::EAGER).findPath(path.front(), path.back(), &waypoints);
+            else waypoints.clear();
+
+            anyAngleShown = anyAngle;
+
+        }
+
+        // resizes come straight from the controls window
+        std::shared_ptr<const GraphVersion> latest = versions.pin();
+
+        if(graphEdited || latest->graph.getRows() != rows || latest->graph.getCols() != cols) {
+            versions.publish(*graph);
+            graphEdited = false;
+        }
+
+        // the lanes search a pinned version, so edits, loads and resizes meanwhile leave them alone
+        if(raceState.startRequested) {
+
+            vector<Search::Algorithm> algorithms;
+            for(int i = 0; i < Search::ALGORITHM_COUNT; i++) if(raceState.selected[i]) algorithms.push_back((Search::Algorithm) i);
+
+            latest = versions.pin();
+            race.start(getSnapshotGraph(latest), algorithms, Graph::Node(startPos.x, startPos.y, cols), Graph::Node(targetPos.x, targetPos.y, cols), (Topology) topology, true);
+
+            raceState.version = latest->number;
+            raceState.rows = rows;
+            raceState.cols = cols;
+            raceState.binRows = std::min(rows, RACE_VIEW_BINS);
+            raceState.binCols = std::min(cols, RACE_VIEW_BINS);
+            raceState.bins.assign(algorithms.size(), vector<int>(raceState.binRows * raceState.binCols, 0));
+            raceState.paths.assign(algorithms.size(), {});
+            raceState.showWindow = true;
+            raceState.startRequested = false;
+
+        }
+
+        if(raceState.stopRequested) {
+            race.stop();
+            raceState.stopRequested = false;
+        }
+
+        for(size_t lane = 0; lane < raceState.bins.size(); lane++) {
+
+            raceNodes.clear();
+            race.takeVisited(lane, &raceNodes);
+
+            for(const Graph::Node &node : raceNodes) {
+                raceState.bins[lane][(node.y * raceState.binRows / raceState.rows) * raceState.binCols + node.x * raceState.binCols / raceState.cols]++;
+            }
+
+            if(raceState.paths[lane].empty() && race.getStatus(lane).finished) race.getPath(lane, &raceState.paths[lane]);
+
+        }
+
+        // stale plans would run through walls of the new graph
+        if(agents.rows != rows || agents.cols != cols) agents.clearRequested = true;
+
+        if(agents.clearRequested) {
+            agents.agents.clear();
+            agents.plans.clear();
+            agents.rows = rows;
+            agents.cols = cols;
+            agents.clearRequested = false;
+        }
+
+        if(flow.clearRequested) {
+            flowField.clear();
+            flow.clearRequested = false;
+        }
+
+        Graph::Node flowTarget = Graph::Node(targetPos.x, targetPos.y, cols);
+
+        if(flow.computeRequested || (agents.planRequested && agents.sharedTarget && (flowField.isEmpty() || flowField.getRows() != rows || flowField.getCols() != cols || flowField.getTarget() != flowTarget))) {
+
+            auto begin = std::chrono::steady_clock::now();
+            flowField.compute(*graph, flowTarget);
+            flow.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+            flow.computeRequested = false;
+
+        }
+
+        if(agents.planRequested) {
+
+            randomAgents(*graph, agents.count, std::random_device()(), &agents.agents);
+
+            auto begin = std::chrono::steady_clock::now();
+
+            if(agents.sharedTarget) {
+                for(Agent &agent : agents.agents) agent.target = flowTarget;
+                followFlowField(flowField, agents.agents, &agents.plans);
+            } else {
+                planner.plan(*graph, (Search::Algorithm) agents.algorithm, agents.agents, &agents.plans);
+            }
+
+            agents.planMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            agents.planRequested = false;
+
+        }
+
+        if(trace.openRequested) {
+
+            trace.openRequested = false;
+
+            if(!trace.player.open(trace.path)) {
+                trace.status = "Failed to open";
+            } else if(trace.player.getRows() != rows || trace.player.getCols() != cols) {
+                trace.status = "Recorded on a different grid size";
+            } else {
+
+                search.reset();
+                traceWriter.reset();
+                path.clear();
+                waypoints.clear();
+                lod.clear(LodPyramid::VISITED);
+                lod.clear(LodPyramid::PATH);
+
+                if(heatmap->getRows() != rows || heatmap->getCols() != cols) heatmap->resize(rows, cols);
+                else heatmap->clear();
+
+                Graph::Node start = trace.player.getStart();
+                Graph::Node target = trace.player.getTarget();
+                startPos = ImVec2(start.x, start.y);
+                targetPos = ImVec2(target.x, target.y);
+                heatmap->setFrontier(start.x, start.y);
+
+                trace.replaying = true;
+                trace.playing = true;
+                trace.position = 0;
+                trace.status = "Replaying";
+
+            }
+
+        }
+
+        if(trace.replaying) {
+
+            double eventCount = trace.player.getEventCount();
+
+            if(trace.playing) trace.position = std::min(trace.position + trace.eventsPerSecond * ImGui::GetIO().DeltaTime, eventCount);
+            if(trace.position >= eventCount) trace.playing = false;
+
+            traceChanges.clear();
+            trace.player.seek((size_t) trace.position, &traceChanges);
+            applyTraceChanges(traceChanges, cols, heatmap.get(), &lod);
+
+            // the path appears once the replay passes the event that found it
+            if(trace.player.isPathShown() && path.empty()) {
+                path = trace.player.getPath();
+                for(const Graph::Node &node : path) lod.add(LodPyramid::PATH, node.x, node.y, 1);
+            } else if(!trace.player.isPathShown() && !path.empty()) {
+                for(const Graph::Node &node : path) lod.add(LodPyramid::PATH, node.x, node.y, -1);
+                path.clear();
+                waypoints.clear();
+            }
+
+        }
+
+        animating = (search && !search->isFinished()) || (trace.replaying && trace.playing) || race.isRunning();
+
+        profiler.beginPhase(Profiler::GRID);
         
         int width, height;
         glfwGetWindowSize(window, &width, &height);
         ImVec2 windowSize = ImVec2(width, height);
         ImVec2 windowCenter = ImVec2(windowSize.x * 0.5f, windowSize.y * 0.5f);
-        ImVec2 gridUpperLeft = ImVec2(250, windowCenter.y - windowSize.y * 0.48f);
-        ImVec2 gridBottomRight = ImVec2(windowCenter.x + windowSize.x * 0.48f, windowCenter.y + windowSize.y * 0.48f);
-        ImVec2 gridDimensions = ImVec2(gridBottomRight.x - gridUpperLeft.x, gridBottomRight.y - gridUpperLeft.y);
-        
-        float tileSize = std::min(gridDimensions.x / cols, gridDimensions.y / rows);
-        ImVec2 tilePos = gridUpperLeft;
+        ImVec2 viewportUpperLeft = ImVec2(250, windowCenter.y - windowSize.y * 0.48f);
+        ImVec2 viewportBottomRight = ImVec2(windowCenter.x + windowSize.x * 0.48f, windowCenter.y + windowSize.y * 0.48f);
 
-        for(auto row = 0; row < rows; row++) {
+        if(resetView) {
+            camera.fit(viewportUpperLeft, viewportBottomRight, rows, cols);
+            resetView = false;
+        }
 
-            for(auto col = 0; col < cols; col++) {
-                
-                ImColor tileColor;
-                if(ImVec2(col, row) == startPos) tileColor = startColor;
-                else if(ImVec2(col, row) == targetPos) tileColor = targetColor;
-                else tileColor = WHITE;
+        profiler.beginPhase(Profiler::INPUT);
+        handleCameraInput(&camera, viewportUpperLeft, viewportBottomRight);
+        profiler.beginPhase(Profiler::GRID);
 
-                backgroundDrawList->AddRectFilled(tilePos, ImVec2(tilePos.x + tileSize, tilePos.y + tileSize), tileColor);
-                foregroundDrawList->AddRect(tilePos, ImVec2(tilePos.x + tileSize, tilePos.y + tileSize), TILE_BORDER_COLOR, 0, 0, 0.2f);
+        // only the cells inside the viewport are processed and drawn
+        ImVec2 visibleUpperLeft = camera.screenToWorld(viewportUpperLeft);
+        ImVec2 visibleBottomRight = camera.screenToWorld(viewportBottomRight);
+        int firstCol = clampToGrid(std::floor(visibleUpperLeft.x), cols);
+        int lastCol = clampToGrid(std::ceil(visibleBottomRight.x), cols);
+        int firstRow = clampToGrid(std::floor(visibleUpperLeft.y), rows);
+        int lastRow = clampToGrid(std::ceil(visibleBottomRight.y), rows);
 
-                Graph::Node currentNode = Graph::Node(col, row, cols);
-                vector<Graph::Node> neighbourNodes = col >= 0 && row >= 0 ? graph->getNeighbors(currentNode) : vector<Graph::Node>();
+        float tileSize = camera.getTileSize();
+        ImVec2 gridUpperLeft = camera.worldToScreen(ImVec2(0, 0));
+        ImVec2 gridBottomRight = camera.worldToScreen(ImVec2(cols, rows));
 
-                if(!vectorHasElement<Graph::Node>(neighbourNodes, Graph::Node(col - 1, row, cols))) {
-                    foregroundDrawList->AddLine(tilePos, ImVec2(tilePos.x, tilePos.y + tileSize), BLACK, 3.0f);
-                }
-                if(!vectorHasElement<Graph::Node>(neighbourNodes, Graph::Node(col, row - 1, cols))) {
-                    foregroundDrawList->AddLine(tilePos, ImVec2(tilePos.x + tileSize, tilePos.y), BLACK, 3.0f);
-                }
-                if(!vectorHasElement<Graph::Node>(neighbourNodes, Graph::Node(col + 1, row, cols))) {
-                    foregroundDrawList->AddLine(ImVec2(tilePos.x + tileSize, tilePos.y), ImVec2(tilePos.x + tileSize, tilePos.y + tileSize), BLACK, 3.0f);
-                }
-                if(!vectorHasElement<Graph::Node>(neighbourNodes, Graph::Node(col, row + 1, cols))) {
-                    foregroundDrawList->AddLine(ImVec2(tilePos.x, tilePos.y + tileSize), ImVec2(tilePos.x + tileSize, tilePos.y + tileSize), BLACK, 3.0f);
-                }
+        backgroundDrawList->PushClipRect(viewportUpperLeft, viewportBottomRight);
+        foregroundDrawList->PushClipRect(viewportUpperLeft, viewportBottomRight);
+
+        backgroundDrawList->AddRectFilled(camera.worldToScreen(ImVec2(firstCol, firstRow)), camera.worldToScreen(ImVec2(lastCol, lastRow)), WHITE);
+
+        if(tileSize < LOD_TILE_SIZE) {
+            drawLod(backgroundDrawList, lod, camera, firstRow, lastRow, firstCol, lastCol);
+        }
+
+        if(showHeatmap && heatmap->getRows() == rows && heatmap->getCols() == cols) {
+            heatmap->upload();
+            heatmap->draw(backgroundDrawList, gridUpperLeft, gridBottomRight);
+        }
+
+        if(startPos.x >= firstCol && startPos.x < lastCol && startPos.y >= firstRow && startPos.y < lastRow) {
+            backgroundDrawList->AddRectFilled(camera.worldToScreen(startPos), camera.worldToScreen(ImVec2(startPos.x + 1, startPos.y + 1)), startColor);
+        }
+        if(targetPos.x >= firstCol && targetPos.x < lastCol && targetPos.y >= firstRow && targetPos.y < lastRow) {
+            backgroundDrawList->AddRectFilled(camera.worldToScreen(targetPos), camera.worldToScreen(ImVec2(targetPos.x + 1, targetPos.y + 1)), targetColor);
+        }
+
+        if(tileSize >= MIN_TILE_BORDER_SIZE) {
 
-                tilePos.x += tileSize;
-                
+            for(auto col = firstCol; col <= lastCol; col++) {
+                foregroundDrawList->AddLine(camera.worldToScreen(ImVec2(col, firstRow)), camera.worldToScreen(ImVec2(col, lastRow)), TILE_BORDER_COLOR, 0.2f);
             }
 
-            if(row < rows - 1) tilePos.x = gridUpperLeft.x;
-            tilePos.y += tileSize;
+            for(auto row = firstRow; row <= lastRow; row++) {
+                foregroundDrawList->AddLine(camera.worldToScreen(ImVec2(firstCol, row)), camera.worldToScreen(ImVec2(lastCol, row)), TILE_BORDER_COLOR, 0.2f);
+            }
+
+        }
+
+        if(tileSize >= LOD_TILE_SIZE) {
+            walls.update(*graph, firstRow, lastRow, firstCol, lastCol);
+            drawWallRuns(foregroundDrawList, walls, camera, firstRow, lastRow, firstCol, lastCol);
+
+            vector<ImVec2> pathPoints;
+            for(const Graph::Node &node : path) pathPoints.push_back(camera.worldToScreen(ImVec2(node.x + 0.5f, node.y + 0.5f)));
+            foregroundDrawList->AddPolyline(pathPoints.data(), pathPoints.size(), PATH_COLOR, 0, std::max(2.0f, tileSize * 0.2f));
+
+            vector<ImVec2> waypointPoints;
+            for(const Graph::Node &node : waypoints) waypointPoints.push_back(camera.worldToScreen(ImVec2(node.x + 0.5f, node.y + 0.5f)));
+            foregroundDrawList->AddPolyline(waypointPoints.data(), waypointPoints.size(), ANY_ANGLE_COLOR, 0, std::max(2.0f, tileSize * 0.1f));
+
+            if(flow.showOverlay && !flowField.isEmpty() && flowField.getRows() == rows && flowField.getCols() == cols) {
+                drawFlowField(backgroundDrawList, foregroundDrawList, flowField, camera, firstRow, lastRow, firstCol, lastCol);
+            }
 
+            drawAgents(foregroundDrawList, agents.agents, agents.plans, camera, tileSize);
         }
 
-        gridBottomRight = tilePos;
         foregroundDrawList->AddRect(gridUpperLeft, gridBottomRight, BLACK, 0, 0, 3.0f);
 
-        handleLeftMouseButton(graph, gridUpperLeft, gridBottomRight, tileSize, &cols);
-        handleRightMouseButton(graph, gridUpperLeft, gridBottomRight, tileSize, &cols);
+        foregroundDrawList->PopClipRect();
+        backgroundDrawList->PopClipRect();
+
+        profiler.beginPhase(Profiler::INPUT);
+
+        if(brushMode == BRUSH_RECTANGLE) {
+            handleRectangleBrush(&edits, foregroundDrawList, viewportUpperLeft, viewportBottomRight, camera, &rows, &cols);
+        } else {
+            handleLeftMouseButton(&edits, viewportUpperLeft, viewportBottomRight, camera, &rows, &cols);
+            handleRightMouseButton(&edits, viewportUpperLeft, viewportBottomRight, camera, &rows, &cols);
+        }
+
+        ImGuiIO &io = ImGui::GetIO();
+
+        if(!io.WantCaptureKeyboard && io.KeyCtrl) {
+            if(ImGui::IsKeyPressed(ImGuiKey_Z)) historyStep = io.KeyShift ? 1 : -1;
+            if(ImGui::IsKeyPressed(ImGuiKey_Y)) historyStep = 1;
+        }
+
+        // all edits of this frame are applied in one batch and the caches invalidated once
+        appliedEdits.clear();
+        edits.apply(graph.get(), &journal, &appliedEdits);
+
+        if(historyStep < 0) journal.undo(graph.get(), &appliedEdits);
+        if(historyStep > 0) journal.redo(graph.get(), &appliedEdits);
+        historyStep = 0;
+
+        applyEdits(appliedEdits, *graph, &walls, &lod);
+        if(!appliedEdits.isEmpty()) graphEdited = true;
+
+        // agents on the shared field just follow the repaired directions
+        if(!flowField.isEmpty() && !appliedEdits.isEmpty()) {
+
+            auto begin = std::chrono::steady_clock::now();
+            flowField.repair(*graph, appliedEdits);
+            flow.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+            if(agents.sharedTarget && !agents.plans.empty()) followFlowField(flowField, agents.agents, &agents.plans);
+
+        }
+
+        // a stroke ends when no mouse button is held anymore
+        if(!ImGui::IsMouseDown(ImGuiMouseButton_Left) && !ImGui::IsMouseDown(ImGuiMouseButton_Right)) journal.commit();
         
         // ===============
         // GUI ENDS HERE
         // ===============
 
+        profiler.beginPhase(Profiler::RENDER);
+
         ImGui::Render();
+
+        profiler.beginPhase(Profiler::SWAP);
+
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         glViewport(0, 0, display_w, display_h);
@@ -287,8 +1541,12 @@ int Application::run() {
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+
+        profiler.endFrame();
     }
 
+    heatmap.reset();
+
     ImGui_ImplGlfw_Shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui::DestroyContext();
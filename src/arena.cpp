@@ -0,0 +1,90 @@
+#include "arena.h"
+#include "memory.h"
+
+// keeps the owned buffer a multiple of a page
+#define ARENA_GRANULARITY 4096
+
+CountingResource::CountingResource(std::pmr::memory_resource *upstream): m_upstream(upstream), m_allocations(0), m_bytes(0) {}
+
+size_t CountingResource::getAllocationCount() const {
+    return m_allocations;
+}
+
+size_t CountingResource::getAllocatedBytes() const {
+    return m_bytes;
+}
+
+void *CountingResource::do_allocate(size_t bytes, size_t alignment) {
+
+    m_allocations++;
+    m_bytes += bytes;
+
+    return m_upstream->allocate(bytes, alignment);
+
+}
+
+void CountingResource::do_deallocate(void *pointer, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+SearchArena::SearchArena(): m_heap(getTrackingResource(MEMORY_SEARCH)), m_buffer(nullptr), m_capacity(0), m_heapBytesAtReset(0) {
+    m_arena.emplace(&m_heap);
+}
+
+SearchArena::~SearchArena() {
+
+    m_arena.reset();
+    if(m_buffer) m_heap.deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+
+}
+
+std::pmr::memory_resource *SearchArena::getResource() {
+    return &*m_arena;
+}
+
+void SearchArena::reset() {
+
+    // bytes the arena fetched beyond its buffer since the last reset
+    size_t overflow = m_heap.getAllocatedBytes() - m_heapBytesAtReset;
+
+    m_arena.reset();
+
+    if(overflow > 0) {
+
+        if(m_buffer) m_heap.deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+
+        m_capacity = (m_capacity + overflow + ARENA_GRANULARITY - 1) / ARENA_GRANULARITY * ARENA_GRANULARITY;
+        m_buffer = m_heap.allocate(m_capacity, alignof(std::max_align_t));
+
+    }
+
+    if(m_buffer) m_arena.emplace(m_buffer, m_capacity, &m_heap);
+    else m_arena.emplace(&m_heap);
+
+    m_heapBytesAtReset = m_heap.getAllocatedBytes();
+
+}
+
+SearchArena &SearchArena::forThread() {
+
+    static thread_local SearchArena arena;
+
+    return arena;
+
+}
+
+size_t SearchArena::getHeapAllocations() const {
+    return m_heap.getAllocationCount();
+}
+
+size_t SearchArena::getHeapBytes() const {
+    return m_heap.getAllocatedBytes();
+}
+
+size_t SearchArena::getCapacity() const {
+    return m_capacity;
+}
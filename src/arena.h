@@ -0,0 +1,64 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+// Forwards to another resource and counts what passes through, so callers
+// can check that a steady state stops reaching the heap.
+class CountingResource : public std::pmr::memory_resource {
+
+public:
+    CountingResource(std::pmr::memory_resource *upstream);
+
+    size_t getAllocationCount() const;
+    size_t getAllocatedBytes() const;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    std::pmr::memory_resource *m_upstream;
+    size_t m_allocations;
+    size_t m_bytes;
+
+};
+
+// Monotonic arena for the buffers of one query at a time. Allocations only
+// bump a pointer and freeing is a no-op; reset() drops everything at once.
+// Whatever a query had to fetch from the heap beyond the owned buffer is
+// folded into it on the next reset, so once the buffer has grown to the
+// largest query no further query touches the heap.
+class SearchArena {
+
+public:
+    SearchArena();
+    ~SearchArena();
+
+    SearchArena(const SearchArena&) = delete;
+    SearchArena &operator=(const SearchArena&) = delete;
+
+    std::pmr::memory_resource *getResource();
+
+    // everything allocated since the last reset must be dead by now
+    void reset();
+
+    // one arena per thread, for callers without their own
+    static SearchArena &forThread();
+
+    size_t getHeapAllocations() const;
+    size_t getHeapBytes() const;
+    size_t getCapacity() const;
+
+private:
+    CountingResource m_heap;
+    std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+    void *m_buffer;
+    size_t m_capacity;
+    size_t m_heapBytesAtReset;
+
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "anyangle.h"
+#include "arena.h"
+#include "graph.h"
+#include "maze.h"
+#include "search.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Micro and macro benchmarks for the core library. Every benchmark runs a
+// number of timed samples; each pass of a sample sets up its own fixture
+// outside the timed region and reports how many operations it timed. Results go to a
+// JSON file (or stdout) with the median and fastest ns/op per benchmark.
+
+#define BENCH_DEFAULT_SIZES "50x80,500x800,2000x2000,4096x4096,16384x16384"
+#define BENCH_DEFAULT_REPETITIONS 5
+#define BENCH_DEFAULT_MAX_SEARCH_CELLS (1 << 24)
+
+// set by CMake from the build configuration
+#ifndef PATHFINDING_BUILD_TYPE
+#define PATHFINDING_BUILD_TYPE "unknown"
+#endif
+
+// per-cell micro benchmarks visit at most this many cells per pass
+#define BENCH_MAX_OPS (1 << 22)
+
+// queries per pass of the short query benchmark, each capped at this many expansions
+#define BENCH_SHORT_QUERIES 1000
+#define BENCH_SHORT_QUERY_EXPANSIONS 64
+
+// a sample repeats its pass until this much time was measured, so small grids are not lost in timer noise
+#define BENCH_MIN_SAMPLE_SECONDS 0.02
+
+using std::vector;
+
+struct Sample {
+    double seconds;
+    double ops;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string unit;
+    int rows;
+    int cols;
+    double ops;
+    double medianNsPerOp;
+    double minNsPerOp;
+    long peakRssKb;
+    vector<double> samples;
+};
+
+// keeps results alive so the compiler cannot drop the measured work
+volatile uint64_t sink;
+
+class Stopwatch {
+
+public:
+    Stopwatch(): m_begin(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_begin).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_begin;
+
+};
+
+// process high-water mark, so it only ever grows over a run
+long getPeakRssKb() {
+
+#ifndef _WIN32
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+
+    return -1;
+
+}
+
+BenchResult measure(const std::string &name, const std::string &unit, const int rows, const int cols, const int repetitions, const std::function<Sample()> &sample) {
+
+    vector<double> nsPerOp;
+    double ops = 0;
+
+    for(auto i = 0; i < repetitions; i++) {
+
+        Sample total = Sample { 0.0, 0.0 };
+
+        while(total.seconds < BENCH_MIN_SAMPLE_SECONDS) {
+            Sample pass = sample();
+            total.seconds += pass.seconds;
+            total.ops += pass.ops;
+        }
+
+        ops = total.ops;
+        nsPerOp.push_back(total.seconds * 1e9 / std::max(total.ops, 1.0));
+
+    }
+
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    BenchResult result = BenchResult { name, unit, rows, cols, ops, nsPerOp[nsPerOp.size() / 2], nsPerOp.front(), getPeakRssKb(), nsPerOp };
+    std::fprintf(stderr, "%-28s %6dx%-6d %12.2f ns/%s\n", name.c_str(), rows, cols, result.medianNsPerOp, unit.c_str());
+
+    return result;
+
+}
+
+// spreads the sampled cells over the whole grid instead of the first rows only
+Graph::Node sampledCell(const uint64_t i, const uint64_t cells, const int cols) {
+
+    uint64_t id = (i * 2654435761ULL) % cells;
+
+    return Graph::Node(id % cols, id / cols, cols);
+
+}
+
+void openGrid(Graph *graph) {
+    graph->clearRect(0, 0, graph->getCols(), graph->getRows());
+}
+
+void runGraphBenchmarks(const int rows, const int cols, const int repetitions, vector<BenchResult> *results) {
+
+    uint64_t cells = (uint64_t) rows * cols;
+    uint64_t sampled = std::min<uint64_t>(cells, BENCH_MAX_OPS);
+
+    results->push_back(measure("graph/construct", "cell", rows, cols, repetitions, [&]() {
+        Stopwatch watch;
+        Graph graph = Graph(rows, cols);
+        double seconds = watch.seconds();
+        sink = sink + graph.getWordsPerRow();
+        return Sample { seconds, (double) cells };
+    }));
+
+    results->push_back(measure("graph/resize", "call", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        openGrid(&graph);
+        Stopwatch watch;
+        graph.resize(rows + rows / 2, cols + cols / 2);
+        graph.resize(rows, cols);
+        return Sample { watch.seconds(), 2.0 };
+    }));
+
+    results->push_back(measure("graph/addEdge", "edge", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        double edges = 0;
+        Stopwatch watch;
+        for(uint64_t i = 0; i < sampled; i++) {
+            Graph::Node node = sampledCell(i, cells, cols);
+            if(node.x + 1 < cols) {
+                graph.addEdge(node, Graph::Node(node.x + 1, node.y, cols));
+                edges++;
+            }
+            if(node.y + 1 < rows) {
+                graph.addEdge(node, Graph::Node(node.x, node.y + 1, cols));
+                edges++;
+            }
+        }
+        return Sample { watch.seconds(), edges };
+    }));
+
+    results->push_back(measure("graph/removeAllNeighbors", "cell", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        openGrid(&graph);
+        Stopwatch watch;
+        for(uint64_t i = 0; i < sampled; i++) graph.removeAllNeighbors(sampledCell(i, cells, cols));
+        return Sample { watch.seconds(), (double) sampled };
+    }));
+
+    results->push_back(measure("graph/getNeighbors", "cell", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        openGrid(&graph);
+        uint64_t total = 0;
+        Stopwatch watch;
+        for(uint64_t i = 0; i < sampled; i++) total += graph.getNeighbors(sampledCell(i, cells, cols)).size();
+        double seconds = watch.seconds();
+        sink = sink + total;
+        return Sample { seconds, (double) sampled };
+    }));
+
+    // publishing a version for readers on other threads and editing one cell afterwards, which clones a single band
+    results->push_back(measure("graph/snapshot-edit", "call", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        openGrid(&graph);
+        GraphVersions versions = GraphVersions(graph);
+        Stopwatch watch;
+        versions.publish(graph);
+        graph.setPassages(Graph::Node(cols / 2, rows / 2, cols), 0);
+        double seconds = watch.seconds();
+        sink = sink + versions.pin()->number;
+        return Sample { seconds, 1.0 };
+    }));
+
+}
+
+void runMazeBenchmarks(const int rows, const int cols, const int repetitions, vector<BenchResult> *results) {
+
+    uint64_t cells = (uint64_t) rows * cols;
+
+    results->push_back(measure("maze/kruskal", "cell", rows, cols, repetitions, [&]() {
+        Graph graph = Graph(rows, cols);
+        Stopwatch watch;
+        generateMaze(&graph, KRUSKAL, 1);
+        return Sample { watch.seconds(), (double) cells };
+    }));
+
+    Graph maze = Graph(rows, cols);
+    generateMaze(&maze, KRUSKAL, 1);
+
+    // search buffers come from an arena reset before every pass, as a long running service would keep one
+    SearchArena arena;
+
+    for(auto i = 0; i < Search::ALGORITHM_COUNT; i++) {
+        for(auto topology = 0; topology < TOPOLOGY_COUNT; topology++) {
+            for(auto layout = 0; layout < Search::LAYOUT_COUNT; layout++) {
+
+                Search::Algorithm algorithm = (Search::Algorithm) i;
+                if(!isGraphTopology((Topology) topology)) continue;
+                // the layout only changes memory order, comparing it under one algorithm is enough
+                if(layout != Search::ROW_MAJOR && algorithm != Search::DIJKSTRA) continue;
+
+                // 4-connected row-major keeps the plain name, the one older results were recorded under
+                std::string name = std::string("search/") + Search::getAlgorithmName(algorithm);
+                if(topology != FOUR_CONNECTED) name += std::string("/") + getTopologyName((Topology) topology);
+                if(layout != Search::ROW_MAJOR) name += std::string("/") + Search::getLayoutName((Search::CellLayout) layout);
+
+                // corner to corner through a perfect maze, per node expansion
+                results->push_back(measure(name, "expansion", rows, cols, repetitions, [&]() {
+                    arena.reset();
+                    Stopwatch watch;
+                    Search search = Search(maze, algorithm, Graph::Node(0, 0, cols), Graph::Node(cols - 1, rows - 1, cols), (Topology) topology, arena.getResource(), (Search::CellLayout) layout);
+                    while(!search.step(INT32_MAX, nullptr, nullptr));
+                    double seconds = watch.seconds();
+                    sink = sink + search.getPathLength();
+                    return Sample { seconds, (double) search.getExpansions() };
+                }));
+
+            }
+        }
+    }
+
+    // any-angle paths corner to corner: string pulling per grid path node, Theta* per expansion
+    Search corners = Search(maze, Search::DIJKSTRA, Graph::Node(0, 0, cols), Graph::Node(cols - 1, rows - 1, cols), EIGHT_CONNECTED_NO_CORNER_CUTTING);
+    while(!corners.step(INT32_MAX, nullptr, nullptr));
+    vector<Graph::Node> cornerPath = corners.getPath();
+
+    results->push_back(measure("anyangle/pull", "node", rows, cols, repetitions, [&]() {
+        vector<Graph::Node> waypoints;
+        Stopwatch watch;
+        pullString(maze, cornerPath, &waypoints);
+        double seconds = watch.seconds();
+        sink = sink + waypoints.size();
+        return Sample { seconds, (double) cornerPath.size() };
+    }));
+
+    for(auto variant = 0; variant < 2; variant++) {
+        results->push_back(measure(variant == ThetaStar::LAZY ? "anyangle/lazy-theta" : "anyangle/theta", "expansion", rows, cols, repetitions, [&]() {
+            ThetaStar theta = ThetaStar(maze, (ThetaStar::Variant) variant);
+            vector<Graph::Node> waypoints;
+            Stopwatch watch;
+            theta.findPath(Graph::Node(0, 0, cols), Graph::Node(cols - 1, rows - 1, cols), &waypoints);
+            double seconds = watch.seconds();
+            sink = sink + waypoints.size();
+            return Sample { seconds, (double) theta.getExpansions() };
+        }));
+    }
+
+    // many short queries on one restarted search, the cost should follow the cells reached rather than the grid size
+    for(auto layout = 0; layout < Search::LAYOUT_COUNT; layout++) {
+
+        std::string name = "search/short-query";
+        if(layout != Search::ROW_MAJOR) name += std::string("/") + Search::getLayoutName((Search::CellLayout) layout);
+
+        results->push_back(measure(name, "query", rows, cols, repetitions, [&]() {
+            uint64_t cells = (uint64_t) rows * cols;
+            Search search = Search(maze, Search::DIJKSTRA, Graph::Node(0, 0, cols), Graph::Node(0, 0, cols), FOUR_CONNECTED, std::pmr::get_default_resource(), (Search::CellLayout) layout);
+            int expansions = 0;
+            Stopwatch watch;
+            for(auto i = 0; i < BENCH_SHORT_QUERIES; i++) {
+                Graph::Node start = sampledCell(i, cells, cols);
+                search.restart(start, Graph::Node(std::min(start.x + 2, cols - 1), std::min(start.y + 2, rows - 1), cols));
+                search.step(BENCH_SHORT_QUERY_EXPANSIONS, nullptr, nullptr);
+                expansions += search.getExpansions();
+            }
+            double seconds = watch.seconds();
+            sink = sink + expansions;
+            return Sample { seconds, (double) BENCH_SHORT_QUERIES };
+        }));
+
+    }
+
+}
+
+bool parseSizes(const std::string &text, vector<std::pair<int, int>> *sizes) {
+
+    size_t begin = 0;
+
+    while(begin < text.size()) {
+
+        size_t end = text.find(',', begin);
+        if(end == std::string::npos) end = text.size();
+
+        int rows, cols;
+        if(std::sscanf(text.substr(begin, end - begin).c_str(), "%dx%d", &rows, &cols) != 2 || rows <= 0 || cols <= 0) return false;
+
+        sizes->push_back(std::make_pair(rows, cols));
+        begin = end + 1;
+
+    }
+
+    return !sizes->empty();
+
+}
+
+void writeJson(std::FILE *file, const vector<BenchResult> &results) {
+
+    std::fprintf(file, "{\n  \"build_type\": \"%s\",\n  \"peak_rss_kb\": %ld,\n  \"benchmarks\": [\n", PATHFINDING_BUILD_TYPE, getPeakRssKb());
+
+    for(size_t i = 0; i < results.size(); i++) {
+
+        const BenchResult &result = results[i];
+
+        std::fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"rows\": %d, \"cols\": %d, \"ops\": %.0f, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"ops_per_s\": %.1f, \"peak_rss_kb\": %ld, \"samples_ns_per_op\": [",
+            result.name.c_str(), result.unit.c_str(), result.rows, result.cols, result.ops, result.medianNsPerOp, result.minNsPerOp,
+            result.medianNsPerOp > 0 ? 1e9 / result.medianNsPerOp : 0.0, result.peakRssKb);
+
+        for(size_t sample = 0; sample < result.samples.size(); sample++) std::fprintf(file, "%s%.3f", sample > 0 ? ", " : "", result.samples[sample]);
+
+        // one benchmark per line, pathfinding-benchcompare relies on it
+        std::fprintf(file, "]}%s\n", i + 1 < results.size() ? "," : "");
+
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+
+}
+
+int main(int argc, char **argv) {
+
+    std::string sizeList = BENCH_DEFAULT_SIZES;
+    std::string out;
+    int repetitions = BENCH_DEFAULT_REPETITIONS;
+    uint64_t maxSearchCells = BENCH_DEFAULT_MAX_SEARCH_CELLS;
+
+    for(auto i = 1; i + 1 < argc; i += 2) {
+
+        std::string key = argv[i];
+
+        if(key == "--sizes") sizeList = argv[i + 1];
+        else if(key == "--repetitions") repetitions = std::max(1, std::atoi(argv[i + 1]));
+        else if(key == "--max-search-cells") maxSearchCells = std::strtoull(argv[i + 1], nullptr, 10);
+        else if(key == "--out") out = argv[i + 1];
+
+    }
+
+    vector<std::pair<int, int>> sizes;
+
+    if(argc % 2 == 0 || !parseSizes(sizeList, &sizes)) {
+        std::fprintf(stderr, "usage: pathfinding-bench [--sizes RxC,...] [--repetitions N] [--max-search-cells N] [--out FILE]\n");
+        return 2;
+    }
+
+    vector<BenchResult> results;
+
+    for(const auto &size : sizes) {
+
+        runGraphBenchmarks(size.first, size.second, repetitions, &results);
+
+        // generation and search need several bytes per cell, the largest grids only run the graph benchmarks
+        if((uint64_t) size.first * size.second <= maxSearchCells) runMazeBenchmarks(size.first, size.second, repetitions, &results);
+        else std::fprintf(stderr, "skipping maze and search benchmarks for %dx%d\n", size.first, size.second);
+
+    }
+
+    std::FILE *file = out.empty() ? stdout : std::fopen(out.c_str(), "w");
+    if(!file) return 1;
+
+    writeJson(file, results);
+    if(file != stdout) std::fclose(file);
+
+    return 0;
+
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Regression gate for pathfinding-bench results. Every benchmark present in
+// both files is compared with a one-sided Mann-Whitney U test on the per
+// sample ns/op; it counts as a regression when the current run is slower
+// with p below alpha and the medians differ by at least the minimum effect.
+// Exits 1 if anything regressed, 2 on usage or read errors or when the runs
+// come from different build types.
+
+#define DEFAULT_ALPHA 0.01
+#define DEFAULT_MIN_EFFECT 0.10
+
+// exact U distribution up to this many samples per side, normal approximation above
+#define EXACT_SAMPLE_LIMIT 20
+
+using std::vector;
+
+typedef std::tuple<std::string, int, int> BenchKey;
+
+// pulls a field out of one benchmark line as written by pathfinding-bench
+bool findField(const std::string &line, const std::string &key, size_t *position) {
+
+    size_t found = line.find("\"" + key + "\": ");
+    if(found == std::string::npos) return false;
+
+    *position = found + key.size() + 4;
+
+    return true;
+
+}
+
+// the build_type line near the top, "unknown" for results written before it existed
+std::string readBuildType(const std::string &path) {
+
+    std::ifstream file(path);
+    std::string line;
+
+    while(std::getline(file, line)) {
+
+        size_t position;
+        if(!findField(line, "build_type", &position) || line[position] != '"') continue;
+
+        size_t end = line.find('"', position + 1);
+        if(end != std::string::npos) return line.substr(position + 1, end - position - 1);
+
+    }
+
+    return "unknown";
+
+}
+
+bool readResults(const std::string &path, std::map<BenchKey, vector<double>> *results) {
+
+    std::ifstream file(path);
+    if(!file) return false;
+
+    std::string line;
+
+    while(std::getline(file, line)) {
+
+        size_t name, rows, cols, samples;
+        if(!findField(line, "name", &name) || !findField(line, "rows", &rows) || !findField(line, "cols", &cols) || !findField(line, "samples_ns_per_op", &samples)) continue;
+
+        size_t nameEnd = line.find('"', name + 1);
+        if(line[name] != '"' || nameEnd == std::string::npos) return false;
+
+        BenchKey key = BenchKey(line.substr(name + 1, nameEnd - name - 1), std::atoi(&line[rows]), std::atoi(&line[cols]));
+        vector<double> &values = (*results)[key];
+
+        const char *cursor = &line[samples + 1];
+        char *end;
+
+        for(double value = std::strtod(cursor, &end); end != cursor; value = std::strtod(cursor, &end)) {
+            values.push_back(value);
+            cursor = end;
+            while(*cursor == ',' || *cursor == ' ') cursor++;
+        }
+
+        if(values.empty()) return false;
+
+    }
+
+    return !results->empty();
+
+}
+
+double median(vector<double> values) {
+
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+
+}
+
+// number of orderings of m baseline and n current samples for every value of U
+vector<double> exactUCounts(const int m, const int n) {
+
+    // counts[i][j] holds the distribution for i baseline and j current samples
+    vector<vector<vector<double>>> counts = vector<vector<vector<double>>>(m + 1, vector<vector<double>>(n + 1));
+
+    for(auto i = 0; i <= m; i++) {
+        for(auto j = 0; j <= n; j++) {
+
+            counts[i][j].assign(i * j + 1, 0);
+
+            if(i == 0 || j == 0) {
+                counts[i][j][0] = 1;
+                continue;
+            }
+
+            // the largest sample is either a current one (beating all i baseline samples) or a baseline one
+            for(auto u = 0; u <= i * j; u++) {
+                if(u >= i) counts[i][j][u] += counts[i][j - 1][u - i];
+                if(u <= (i - 1) * j) counts[i][j][u] += counts[i - 1][j][u];
+            }
+
+        }
+    }
+
+    return counts[m][n];
+
+}
+
+// P(U >= observed) under the null hypothesis, U counting current samples slower than baseline ones
+double mannWhitneySlowerP(const vector<double> &baseline, const vector<double> &current) {
+
+    int m = baseline.size();
+    int n = current.size();
+    double u = 0;
+    bool ties = false;
+
+    for(double b : baseline) {
+        for(double c : current) {
+            if(c > b) {
+                u += 1;
+            } else if(c == b) {
+                u += 0.5;
+                ties = true;
+            }
+        }
+    }
+
+    if(!ties && m <= EXACT_SAMPLE_LIMIT && n <= EXACT_SAMPLE_LIMIT) {
+
+        vector<double> counts = exactUCounts(m, n);
+        double total = 0;
+        double tail = 0;
+
+        for(size_t value = 0; value < counts.size(); value++) {
+            total += counts[value];
+            if(value >= u) tail += counts[value];
+        }
+
+        return tail / total;
+
+    }
+
+    // normal approximation with tie correction and continuity correction
+    vector<double> pooled = baseline;
+    pooled.insert(pooled.end(), current.begin(), current.end());
+    std::sort(pooled.begin(), pooled.end());
+
+    double tieTerm = 0;
+
+    for(size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while(j < pooled.size() && pooled[j] == pooled[i]) j++;
+        double t = j - i;
+        tieTerm += t * t * t - t;
+        i = j;
+    }
+
+    double total = m + n;
+    double variance = m * n / 12.0 * ((total + 1) - tieTerm / (total * (total - 1)));
+    if(variance <= 0) return 1.0;
+
+    double z = (u - m * n / 2.0 - 0.5) / std::sqrt(variance);
+
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+
+}
+
+int main(int argc, char **argv) {
+
+    if(argc < 3) {
+        std::fprintf(stderr, "usage: pathfinding-benchcompare BASELINE.json CURRENT.json [--alpha P] [--min-effect FRACTION]\n");
+        return 2;
+    }
+
+    double alpha = DEFAULT_ALPHA;
+    double minEffect = DEFAULT_MIN_EFFECT;
+
+    for(auto i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if(key == "--alpha") alpha = std::atof(argv[i + 1]);
+        else if(key == "--min-effect") minEffect = std::atof(argv[i + 1]);
+    }
+
+    std::map<BenchKey, vector<double>> baseline;
+    std::map<BenchKey, vector<double>> current;
+
+    if(!readResults(argv[1], &baseline) || !readResults(argv[2], &current)) {
+        std::fprintf(stderr, "failed to read benchmark results\n");
+        return 2;
+    }
+
+    // an unoptimized run against an optimized baseline reports nothing but false regressions
+    std::string baselineType = readBuildType(argv[1]);
+    std::string currentType = readBuildType(argv[2]);
+
+    if(baselineType != currentType) {
+        std::fprintf(stderr, "baseline is a %s build, current run a %s build; rebuild with CMAKE_BUILD_TYPE=%s to compare\n", baselineType.c_str(), currentType.c_str(), baselineType.c_str());
+        return 2;
+    }
+
+    int regressions = 0;
+
+    std::printf("%-28s %13s %12s %12s %8s %8s\n", "benchmark", "size", "base ns/op", "curr ns/op", "change", "p");
+
+    for(const auto &entry : current) {
+
+        const std::string &name = std::get<0>(entry.first);
+        std::string size = std::to_string(std::get<1>(entry.first)) + "x" + std::to_string(std::get<2>(entry.first));
+
+        auto found = baseline.find(entry.first);
+
+        if(found == baseline.end()) {
+            std::printf("%-28s %13s %12s %12.2f %8s %8s  new\n", name.c_str(), size.c_str(), "-", median(entry.second), "-", "-");
+            continue;
+        }
+
+        double before = median(found->second);
+        double after = median(entry.second);
+        double change = before > 0 ? after / before - 1.0 : 0.0;
+        double p = mannWhitneySlowerP(found->second, entry.second);
+        bool regressed = p < alpha && change >= minEffect;
+
+        if(regressed) regressions++;
+
+        std::printf("%-28s %13s %12.2f %12.2f %+7.1f%% %8.4f%s\n", name.c_str(), size.c_str(), before, after, 100.0 * change, p, regressed ? "  REGRESSION" : "");
+
+    }
+
+    for(const auto &entry : baseline) {
+        if(current.count(entry.first)) continue;
+        std::printf("%-28s %13s  missing from the current run\n", std::get<0>(entry.first).c_str(), (std::to_string(std::get<1>(entry.first)) + "x" + std::to_string(std::get<2>(entry.first))).c_str());
+    }
+
+    std::printf("%d regression%s (alpha %.3f, minimum effect %.1f%%)\n", regressions, regressions == 1 ? "" : "s", alpha, 100.0 * minEffect);
+
+    return regressions > 0 ? 1 : 0;
+
+}
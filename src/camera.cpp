@@ -0,0 +1,43 @@
+#include "camera.h"
+
+#include <algorithm>
+
+#define MIN_TILE_SIZE 0.0001f
+#define MAX_TILE_SIZE 512.0f
+
+Camera::Camera(): m_origin(ImVec2(0, 0)), m_tileSize(1.0f) {}
+
+void Camera::fit(const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const int rows, const int cols) {
+
+    ImVec2 viewportDimensions = ImVec2(viewportBottomRight.x - viewportUpperLeft.x, viewportBottomRight.y - viewportUpperLeft.y);
+
+    m_tileSize = std::clamp(std::min(viewportDimensions.x / cols, viewportDimensions.y / rows), MIN_TILE_SIZE, MAX_TILE_SIZE);
+    m_origin = viewportUpperLeft;
+
+}
+
+void Camera::pan(const ImVec2 delta) {
+    m_origin = ImVec2(m_origin.x + delta.x, m_origin.y + delta.y);
+}
+
+void Camera::zoomAt(const ImVec2 screenPos, const float factor) {
+
+    // keep the world point under the cursor fixed while zooming
+    ImVec2 anchor = screenToWorld(screenPos);
+
+    m_tileSize = std::clamp(m_tileSize * factor, MIN_TILE_SIZE, MAX_TILE_SIZE);
+    m_origin = ImVec2(screenPos.x - anchor.x * m_tileSize, screenPos.y - anchor.y * m_tileSize);
+
+}
+
+ImVec2 Camera::worldToScreen(const ImVec2 world) const {
+    return ImVec2(m_origin.x + world.x * m_tileSize, m_origin.y + world.y * m_tileSize);
+}
+
+ImVec2 Camera::screenToWorld(const ImVec2 screen) const {
+    return ImVec2((screen.x - m_origin.x) / m_tileSize, (screen.y - m_origin.y) / m_tileSize);
+}
+
+float Camera::getTileSize() const {
+    return m_tileSize;
+}
@@ -0,0 +1,26 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "imgui.h"
+
+// Maps grid (world) coordinates, measured in cells, to screen pixels.
+class Camera {
+
+public:
+    Camera();
+
+    void fit(const ImVec2 viewportUpperLeft, const ImVec2 viewportBottomRight, const int rows, const int cols);
+    void pan(const ImVec2 delta);
+    void zoomAt(const ImVec2 screenPos, const float factor);
+
+    ImVec2 worldToScreen(const ImVec2 world) const;
+    ImVec2 screenToWorld(const ImVec2 screen) const;
+    float getTileSize() const;
+
+private:
+    ImVec2 m_origin;
+    float m_tileSize;
+
+};
+
+#endif
@@ -0,0 +1,503 @@
+#include "agents.h"
+#include "anyangle.h"
+#include "arena.h"
+#include "graph.h"
+#include "maze.h"
+#include "mazefile.h"
+#include "memory.h"
+#include "movingai.h"
+#include "race.h"
+#include "search.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+
+// Headless front end to the core library: generate, load, search and time
+// mazes without a display.
+
+typedef std::map<std::string, std::string> Options;
+
+void printUsage() {
+
+    std::printf(
+        "usage: pathfinding-cli <command> [options]\n"
+        "\n"
+        "  generate --rows N --cols N [--seed N] [--format plain|rle|mappable] --out FILE\n"
+        "  search   (--maze FILE | --map FILE | --rows N --cols N [--seed N])\n"
+        "           [--from X,Y] [--to X,Y] [--algorithm dijkstra] [--repeat N] [--trace FILE]\n"
+        "           [--topology four|eight|eight-strict|hex|voxel] [--layers N] [--layout row|morton]\n"
+        "           [--any-angle off|pull|theta|lazy-theta]\n"
+        "  scen     --map FILE --scen FILE [--algorithm dijkstra] [--topology four|eight|eight-strict] [--csv FILE]\n"
+        "  agents   --rows N --cols N [--seed N] [--count N] [--threads N] [--ticks N] [--algorithm dijkstra]\n"
+        "           [--mode search|flow]\n"
+        "  race     (--maze FILE | --map FILE | --rows N --cols N [--seed N])\n"
+        "           [--from X,Y] [--to X,Y] [--algorithms dijkstra,astar,bfs,jps] [--topology four|eight|eight-strict]\n"
+    );
+
+}
+
+// --key value pairs after the command; false on a dangling key or a stray value
+bool parseOptions(const int argc, char **argv, Options *options) {
+
+    for(auto i = 2; i < argc; i += 2) {
+
+        std::string key = argv[i];
+        if(key.rfind("--", 0) != 0 || i + 1 >= argc) return false;
+
+        (*options)[key.substr(2)] = argv[i + 1];
+
+    }
+
+    return true;
+
+}
+
+std::string getOption(const Options &options, const std::string &key, const std::string &fallback) {
+
+    auto it = options.find(key);
+
+    return it == options.end() ? fallback : it->second;
+
+}
+
+bool parseAlgorithm(const std::string &name, Search::Algorithm *algorithm) {
+
+    for(auto i = 0; i < Search::ALGORITHM_COUNT; i++) {
+
+        if(name != Search::getAlgorithmName((Search::Algorithm) i)) continue;
+
+        *algorithm = (Search::Algorithm) i;
+        return true;
+
+    }
+
+    return false;
+
+}
+
+bool parseTopology(const std::string &name, Topology *topology) {
+
+    for(auto i = 0; i < TOPOLOGY_COUNT; i++) {
+
+        if(name != getTopologyName((Topology) i)) continue;
+
+        *topology = (Topology) i;
+        return true;
+
+    }
+
+    return false;
+
+}
+
+bool parseLayout(const std::string &name, Search::CellLayout *layout) {
+
+    for(auto i = 0; i < Search::LAYOUT_COUNT; i++) {
+
+        if(name != Search::getLayoutName((Search::CellLayout) i)) continue;
+
+        *layout = (Search::CellLayout) i;
+        return true;
+
+    }
+
+    return false;
+
+}
+
+bool parsePoint(const std::string &text, int *x, int *y) {
+    return std::sscanf(text.c_str(), "%d,%d", x, y) == 2;
+}
+
+// high water marks of the tracked subsystems over the whole run, for sizing machines
+void printMemoryPeaks() {
+
+    for(auto i = 0; i < MEMORY_SUBSYSTEM_COUNT; i++) {
+        MemoryStats stats = getMemoryStats((MemorySubsystem) i);
+        if(stats.allocations > 0) std::printf("peak_%s_bytes: %zu\n", getMemorySubsystemName((MemorySubsystem) i), stats.peakBytes);
+    }
+
+    std::printf("peak_tracked_bytes: %zu\n", getTotalMemoryStats().peakBytes);
+
+}
+
+double millisecondsSince(const std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// --maze, --map or a generated --rows x --cols maze; returns the exit status on failure, 0 otherwise
+int loadGraph(const Options &options, Graph *graph) {
+
+    if(options.count("maze")) {
+
+        if(!loadMaze(graph, options.at("maze"))) {
+            std::fprintf(stderr, "failed to load %s\n", options.at("maze").c_str());
+            return 1;
+        }
+
+    } else if(options.count("map")) {
+
+        if(!loadMovingAiMap(graph, options.at("map"))) {
+            std::fprintf(stderr, "failed to import %s\n", options.at("map").c_str());
+            return 1;
+        }
+
+    } else {
+
+        int rows = std::atoi(getOption(options, "rows", "0").c_str());
+        int cols = std::atoi(getOption(options, "cols", "0").c_str());
+        if(rows <= 0 || cols <= 0) return 2;
+
+        *graph = Graph(rows, cols);
+        generateMaze(graph, KRUSKAL, std::strtoul(getOption(options, "seed", "1").c_str(), nullptr, 10));
+
+    }
+
+    return 0;
+
+}
+
+int runGenerate(const Options &options) {
+
+    int rows = std::atoi(getOption(options, "rows", "0").c_str());
+    int cols = std::atoi(getOption(options, "cols", "0").c_str());
+    uint32_t seed = std::strtoul(getOption(options, "seed", "1").c_str(), nullptr, 10);
+    std::string format = getOption(options, "format", "rle");
+    std::string out = getOption(options, "out", "");
+
+    uint16_t flags = format == "rle" ? MAZE_FILE_RLE : format == "mappable" ? MAZE_FILE_MAPPABLE : 0;
+    if(rows <= 0 || cols <= 0 || out.empty() || (flags == 0 && format != "plain")) return 2;
+
+    auto begin = std::chrono::steady_clock::now();
+    Graph graph = Graph(rows, cols);
+    generateMaze(&graph, KRUSKAL, seed);
+    std::printf("generate_ms: %.3f\n", millisecondsSince(begin));
+
+    begin = std::chrono::steady_clock::now();
+    if(!saveMaze(graph, out, flags)) {
+        std::fprintf(stderr, "failed to write %s\n", out.c_str());
+        return 1;
+    }
+    std::printf("save_ms: %.3f\n", millisecondsSince(begin));
+
+    return 0;
+
+}
+
+int runSearch(const Options &options) {
+
+    Search::Algorithm algorithm = Search::DIJKSTRA;
+    Topology topology = FOUR_CONNECTED;
+    Search::CellLayout layout = Search::ROW_MAJOR;
+    if(!parseAlgorithm(getOption(options, "algorithm", "dijkstra"), &algorithm)) return 2;
+    if(!parseTopology(getOption(options, "topology", "four"), &topology)) return 2;
+    if(!parseLayout(getOption(options, "layout", "row"), &layout)) return 2;
+
+    std::string anyAngle = getOption(options, "any-angle", "off");
+    if(anyAngle != "off" && anyAngle != "pull" && anyAngle != "theta" && anyAngle != "lazy-theta") return 2;
+    if(anyAngle != "off" && !isGraphTopology(topology)) return 2;
+
+    Graph graph = Graph(0, 0);
+    PassageGrid grid = PassageGrid(0, 0, 0);
+    auto begin = std::chrono::steady_clock::now();
+
+    if(!isGraphTopology(topology)) {
+
+        // hex and voxel maps only come from the generator
+        int layers = topology == VOXEL ? std::atoi(getOption(options, "layers", "4").c_str()) : 1;
+        int rows = std::atoi(getOption(options, "rows", "0").c_str());
+        int cols = std::atoi(getOption(options, "cols", "0").c_str());
+        if(layers <= 0 || rows <= 0 || cols <= 0) return 2;
+
+        grid = PassageGrid(layers, rows, cols);
+        generateMaze(&grid, topology, KRUSKAL, std::strtoul(getOption(options, "seed", "1").c_str(), nullptr, 10));
+
+    } else {
+
+        int status = loadGraph(options, &graph);
+        if(status != 0) return status;
+
+    }
+
+    // voxel floors are stacked as rows
+    int rows = isGraphTopology(topology) ? graph.getRows() : grid.getLayers() * grid.getRows();
+    int cols = isGraphTopology(topology) ? graph.getCols() : grid.getCols();
+
+    std::printf("rows: %d\ncols: %d\nload_ms: %.3f\n", rows, cols, millisecondsSince(begin));
+
+    int startX = 0, startY = 0;
+    int targetX = cols - 1, targetY = rows - 1;
+    if(options.count("from") && !parsePoint(options.at("from"), &startX, &startY)) return 2;
+    if(options.count("to") && !parsePoint(options.at("to"), &targetX, &targetY)) return 2;
+
+    if(startX < 0 || startY < 0 || targetX < 0 || targetY < 0 || startX >= cols || targetX >= cols || startY >= rows || targetY >= rows) {
+        std::fprintf(stderr, "start or target outside the grid\n");
+        return 2;
+    }
+
+    Graph::Node start = Graph::Node(startX, startY, cols);
+    Graph::Node target = Graph::Node(targetX, targetY, cols);
+
+    int repeat = std::max(1, std::atoi(getOption(options, "repeat", "1").c_str()));
+    double total = 0;
+
+    // the previous query is gone by the next reset; from the second query on the arena should not need the heap
+    SearchArena arena;
+    size_t heapAllocations = 0;
+    vector<Graph::Node> path;
+
+    for(auto i = 0; i < repeat; i++) {
+
+        arena.reset();
+        size_t heapAllocationsBefore = arena.getHeapAllocations();
+
+        begin = std::chrono::steady_clock::now();
+
+        Search search = isGraphTopology(topology) ? Search(graph, algorithm, start, target, topology, arena.getResource(), layout) : Search(grid, algorithm, start, target, topology, arena.getResource(), layout);
+
+        // recording is part of the timed run, so its overhead shows up in search_ms
+        std::unique_ptr<TraceWriter> trace;
+
+        if(options.count("trace")) {
+
+            trace = std::make_unique<TraceWriter>();
+
+            if(!trace->open(options.at("trace"), rows, cols, start, target)) {
+                std::fprintf(stderr, "failed to write %s\n", options.at("trace").c_str());
+                return 1;
+            }
+
+            search.setTrace(trace.get());
+
+        }
+
+        while(!search.step(INT32_MAX, nullptr, nullptr));
+        if(trace) trace->close();
+
+        total += millisecondsSince(begin);
+        heapAllocations = arena.getHeapAllocations() - heapAllocationsBefore;
+
+        if(i == repeat - 1) std::printf("path_length: %d\npath_cost: %.1f\nexpansions: %d\n", search.getPathLength(), search.getPathCost(), search.getExpansions());
+        if(i == repeat - 1) search.getPath(&path);
+        if(i == repeat - 1) std::printf("graph_bytes: %zu\nsearch_bytes: %zu\n", isGraphTopology(topology) ? graph.getMemoryUsage() : grid.getMemoryUsage(), search.getMemoryUsage());
+
+    }
+
+    std::printf("search_ms: %.3f\nheap_allocations_last_query: %zu\narena_bytes: %zu\n", total / repeat, heapAllocations, arena.getCapacity());
+
+    // string pulling post-processes the path above, Theta* runs its own query
+    if(anyAngle != "off") {
+
+        vector<Graph::Node> waypoints;
+        begin = std::chrono::steady_clock::now();
+
+        if(anyAngle == "pull") {
+            pullString(graph, path, &waypoints);
+            std::printf("pull_ms: %.3f\n", millisecondsSince(begin));
+        } else {
+            ThetaStar theta = ThetaStar(graph, anyAngle == "lazy-theta" ? ThetaStar::LAZY : ThetaStar::EAGER);
+            theta.findPath(start, target, &waypoints);
+            std::printf("theta_ms: %.3f\ntheta_expansions: %d\nline_of_sight_checks: %d\n", millisecondsSince(begin), theta.getExpansions(), theta.getLineOfSightChecks());
+        }
+
+        std::printf("waypoints: %zu\nany_angle_length: %.2f\n", waypoints.size(), getPolylineLength(waypoints));
+
+    }
+
+    printMemoryPeaks();
+
+    return 0;
+
+}
+
+int runScen(const Options &options) {
+
+    Search::Algorithm algorithm = Search::DIJKSTRA;
+    Topology topology = FOUR_CONNECTED;
+    if(!parseAlgorithm(getOption(options, "algorithm", "dijkstra"), &algorithm)) return 2;
+    if(!parseTopology(getOption(options, "topology", "four"), &topology) || !isGraphTopology(topology)) return 2;
+    if(!options.count("map") || !options.count("scen")) return 2;
+
+    Graph graph = Graph(0, 0);
+    vector<Scenario> scenarios;
+    vector<ScenarioResult> results;
+
+    if(!loadMovingAiMap(&graph, options.at("map")) || !loadMovingAiScenarios(options.at("scen"), graph.getCols(), &scenarios)) {
+        std::fprintf(stderr, "failed to read the map or scenarios\n");
+        return 1;
+    }
+
+    runScenarios(graph, algorithm, topology, scenarios, &results);
+
+    int solved = 0;
+    double latency = 0, expansions = 0, gap = 0;
+
+    for(const ScenarioResult &result : results) {
+        if(!result.solved) continue;
+        solved++;
+        latency += result.latencyMs;
+        expansions += result.expansions;
+        gap += result.gap;
+    }
+
+    std::printf("scenarios: %zu\nsolved: %d\n", results.size(), solved);
+    if(solved > 0) std::printf("mean_latency_ms: %.3f\nmean_expansions: %.1f\nmean_gap: %.4f\n", latency / solved, expansions / solved, gap / solved);
+
+    if(options.count("csv") && !dumpScenarioCsv(scenarios, results, options.at("csv"))) {
+        std::fprintf(stderr, "failed to write %s\n", options.at("csv").c_str());
+        return 1;
+    }
+
+    return 0;
+
+}
+
+int runAgents(const Options &options) {
+
+    Search::Algorithm algorithm = Search::DIJKSTRA;
+    if(!parseAlgorithm(getOption(options, "algorithm", "dijkstra"), &algorithm)) return 2;
+
+    int rows = std::atoi(getOption(options, "rows", "0").c_str());
+    int cols = std::atoi(getOption(options, "cols", "0").c_str());
+    int count = std::atoi(getOption(options, "count", "1000").c_str());
+    int ticks = std::max(1, std::atoi(getOption(options, "ticks", "1").c_str()));
+    uint32_t seed = std::strtoul(getOption(options, "seed", "1").c_str(), nullptr, 10);
+    if(rows <= 0 || cols <= 0 || count <= 0) return 2;
+
+    Graph graph = Graph(rows, cols);
+    generateMaze(&graph, KRUSKAL, seed);
+
+    std::string mode = getOption(options, "mode", "search");
+    if(mode != "search" && mode != "flow") return 2;
+
+    AgentPlanner planner = AgentPlanner(std::atoi(getOption(options, "threads", "0").c_str()));
+    FlowField field;
+    vector<Agent> agents;
+    vector<AgentPlan> plans;
+    double total = 0;
+    double expansions = 0;
+
+    // every tick plans a fresh set of agents, the first one also warms up the per-worker buffers
+    for(auto tick = 0; tick < ticks; tick++) {
+
+        randomAgents(graph, count, seed + tick, &agents);
+
+        // flow mode sends everyone to the first agent's target through one shared field
+        if(mode == "flow") for(Agent &agent : agents) agent.target = agents[0].target;
+
+        auto begin = std::chrono::steady_clock::now();
+
+        if(mode == "flow") {
+            field.compute(graph, agents[0].target);
+            followFlowField(field, agents, &plans);
+        } else {
+            planner.plan(graph, algorithm, agents, &plans);
+        }
+
+        total += millisecondsSince(begin);
+
+        for(const AgentPlan &plan : plans) expansions += plan.expansions;
+
+    }
+
+    std::printf("threads: %d\nagents: %d\nticks: %d\n", planner.getThreadCount(), count, ticks);
+    std::printf("tick_ms: %.3f\nagents_per_s: %.1f\nmean_expansions: %.1f\n", total / ticks, (double) count * ticks / (total / 1000.0), expansions / ((double) count * ticks));
+    printMemoryPeaks();
+
+    return 0;
+
+}
+
+// every algorithm on its own thread against one snapshot, all started together
+int runRace(const Options &options) {
+
+    Topology topology = FOUR_CONNECTED;
+    if(!parseTopology(getOption(options, "topology", "four"), &topology) || !isGraphTopology(topology)) return 2;
+
+    vector<Search::Algorithm> algorithms;
+    std::string names = getOption(options, "algorithms", "dijkstra,astar,bfs,jps");
+
+    for(size_t begin = 0; begin <= names.size();) {
+
+        size_t end = std::min(names.find(',', begin), names.size());
+        Search::Algorithm algorithm = Search::DIJKSTRA;
+        if(!parseAlgorithm(names.substr(begin, end - begin), &algorithm)) return 2;
+
+        algorithms.push_back(algorithm);
+        begin = end + 1;
+
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+
+    Graph graph = Graph(0, 0);
+    int status = loadGraph(options, &graph);
+    if(status != 0) return status;
+
+    int rows = graph.getRows();
+    int cols = graph.getCols();
+
+    std::printf("rows: %d\ncols: %d\nload_ms: %.3f\n", rows, cols, millisecondsSince(begin));
+
+    int startX = 0, startY = 0;
+    int targetX = cols - 1, targetY = rows - 1;
+    if(options.count("from") && !parsePoint(options.at("from"), &startX, &startY)) return 2;
+    if(options.count("to") && !parsePoint(options.at("to"), &targetX, &targetY)) return 2;
+
+    if(startX < 0 || startY < 0 || targetX < 0 || targetY < 0 || startX >= cols || targetX >= cols || startY >= rows || targetY >= rows) {
+        std::fprintf(stderr, "start or target outside the grid\n");
+        return 2;
+    }
+
+    AlgorithmRace race;
+    begin = std::chrono::steady_clock::now();
+
+    race.start(std::make_shared<const Graph>(std::move(graph)), algorithms, Graph::Node(startX, startY, cols), Graph::Node(targetX, targetY, cols), topology, false);
+    race.wait();
+
+    std::printf("lanes: %zu\nrace_ms: %.3f\n", race.getLaneCount(), millisecondsSince(begin));
+
+    for(size_t i = 0; i < race.getLaneCount(); i++) {
+
+        RaceStatus lane = race.getStatus(i);
+        const char *name = Search::getAlgorithmName(lane.algorithm);
+
+        std::printf("%s_ms: %.3f\n%s_expansions: %d\n%s_peak_bytes: %zu\n%s_path_cost: %.1f\n", name, lane.wallMs, name, lane.expansions, name, lane.peakBytes, name, lane.pathCost);
+
+    }
+
+    printMemoryPeaks();
+
+    return 0;
+
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+
+    if(argc < 2 || !parseOptions(argc, argv, &options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::string command = argv[1];
+    int status = 2;
+
+    if(command == "generate") status = runGenerate(options);
+    else if(command == "search") status = runSearch(options);
+    else if(command == "scen") status = runScen(options);
+    else if(command == "agents") status = runAgents(options);
+    else if(command == "race") status = runRace(options);
+
+    if(status == 2) printUsage();
+
+    return status;
+
+}
@@ -0,0 +1,367 @@
+#include "edits.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define CELL_RECORD_SIZE 5
+#define WORD_RECORD_HEADER_SIZE 17
+#define WORD_RECORD_FLAG 0x80
+
+void AppliedEdits::clear() {
+
+    cells.clear();
+    regions.clear();
+
+}
+
+bool AppliedEdits::isEmpty() const {
+    return cells.empty() && regions.empty();
+}
+
+EditJournal::EditJournal(const size_t byteBudget): m_byteBudget(byteBudget), m_transactions{ 0 }, m_cursor(0) {}
+
+void EditJournal::record(const CellDelta delta) {
+
+    uint8_t flipped = delta.before ^ delta.after;
+    if(flipped == 0) return;
+
+    discardRedo();
+
+    // repeated edits of a cell within one transaction collapse into a single record
+    auto it = m_openDeltas.find(delta.cell);
+
+    if(it != m_openDeltas.end()) {
+        m_bytes[it->second] ^= flipped;
+        return;
+    }
+
+    m_openDeltas.emplace(delta.cell, m_bytes.size());
+
+    uint8_t packed[CELL_RECORD_SIZE];
+    uint32_t cell = delta.cell;
+    packed[0] = flipped;
+    std::memcpy(packed + 1, &cell, sizeof(cell));
+
+    m_bytes.insert(m_bytes.end(), packed, packed + CELL_RECORD_SIZE);
+
+}
+
+void EditJournal::recordWords(const Graph::Passage plane, const int y0, const int rows, const int word0, const int words, const uint64_t *flipped) {
+
+    discardRedo();
+
+    int32_t header[4] = { y0, rows, word0, words };
+
+    m_bytes.push_back(WORD_RECORD_FLAG | plane);
+    m_bytes.insert(m_bytes.end(), (const uint8_t *) header, (const uint8_t *) header + sizeof(header));
+    m_bytes.insert(m_bytes.end(), (const uint8_t *) flipped, (const uint8_t *) (flipped + (size_t) rows * words));
+
+}
+
+void EditJournal::commit() {
+
+    if(m_bytes.size() == m_transactions.back()) return;
+
+    m_transactions.push_back(m_bytes.size());
+    m_cursor = m_transactions.size() - 1;
+    m_openDeltas.clear();
+
+    trim();
+
+}
+
+void EditJournal::clear() {
+
+    m_bytes.clear();
+    m_transactions.assign(1, 0);
+    m_cursor = 0;
+    m_openDeltas.clear();
+
+}
+
+bool EditJournal::undo(Graph *graph, AppliedEdits *applied) {
+
+    commit();
+    if(!canUndo()) return false;
+
+    m_cursor--;
+    replay(m_transactions[m_cursor], m_transactions[m_cursor + 1], graph, applied);
+
+    return true;
+
+}
+
+bool EditJournal::redo(Graph *graph, AppliedEdits *applied) {
+
+    if(!canRedo()) return false;
+
+    replay(m_transactions[m_cursor], m_transactions[m_cursor + 1], graph, applied);
+    m_cursor++;
+
+    return true;
+
+}
+
+bool EditJournal::canUndo() const {
+    return m_cursor > 0;
+}
+
+bool EditJournal::canRedo() const {
+    return m_cursor + 1 < m_transactions.size();
+}
+
+size_t EditJournal::getByteSize() const {
+    return m_bytes.size();
+}
+
+size_t EditJournal::getTransactionCount() const {
+    return m_transactions.size() - 1;
+}
+
+size_t EditJournal::getMemoryUsage() const {
+
+    size_t index = m_openDeltas.bucket_count() * sizeof(void*) + m_openDeltas.size() * (sizeof(void*) + sizeof(std::pair<const int, size_t>));
+
+    return getCapacityBytes(m_bytes) + getCapacityBytes(m_transactions) + index;
+
+}
+
+// recording after an undo discards the redo history
+void EditJournal::discardRedo() {
+
+    if(m_cursor + 1 >= m_transactions.size()) return;
+
+    m_bytes.resize(m_transactions[m_cursor]);
+    m_transactions.resize(m_cursor + 1);
+    m_openDeltas.clear();
+
+}
+
+// flips every record in [begin, end); flips commute, so the order does not matter
+void EditJournal::replay(const size_t begin, const size_t end, Graph *graph, AppliedEdits *applied) const {
+
+    int cols = graph->getCols();
+    size_t offset = begin;
+
+    while(offset < end) {
+
+        uint8_t tag = m_bytes[offset];
+
+        if(!(tag & WORD_RECORD_FLAG)) {
+
+            uint32_t cell;
+            std::memcpy(&cell, &m_bytes[offset + 1], sizeof(cell));
+
+            Graph::Node node = Graph::Node(cell % cols, cell / cols, cols);
+            uint8_t before = graph->getPassages(node);
+
+            graph->setPassages(node, before ^ tag);
+            applied->cells.push_back(CellDelta{ (int) cell, before, (uint8_t) (before ^ tag) });
+
+            offset += CELL_RECORD_SIZE;
+            continue;
+
+        }
+
+        int32_t header[4];
+        std::memcpy(header, &m_bytes[offset + 1], sizeof(header));
+
+        Graph::Passage plane = (Graph::Passage) (tag & ~WORD_RECORD_FLAG);
+        int y0 = header[0], rows = header[1], word0 = header[2], words = header[3];
+        const uint8_t *flipped = &m_bytes[offset + WORD_RECORD_HEADER_SIZE];
+
+        for(auto row = 0; row < rows; row++) {
+            for(auto word = 0; word < words; word++) {
+                uint64_t mask;
+                std::memcpy(&mask, flipped + ((size_t) row * words + word) * sizeof(uint64_t), sizeof(mask));
+                graph->xorPassageWord(plane, y0 + row, word0 + word, mask);
+            }
+        }
+
+        // the cells one to the right and below also see their passages change
+        applied->regions.push_back(EditRegion{ word0 * 64, y0, std::min((word0 + words) * 64 + 1, cols), std::min(y0 + rows + 1, graph->getRows()) });
+
+        offset += WORD_RECORD_HEADER_SIZE + (size_t) rows * words * sizeof(uint64_t);
+
+    }
+
+}
+
+// drops whole transactions from the front until the journal fits its budget again
+void EditJournal::trim() {
+
+    if(m_bytes.size() <= m_byteBudget) return;
+
+    // trim to three quarters of the budget so the erase is amortized
+    size_t target = m_bytes.size() - m_byteBudget * 3 / 4;
+    size_t dropped = 0;
+
+    while(dropped < m_cursor && m_transactions[dropped] < target) dropped++;
+    if(dropped == 0) return;
+
+    size_t droppedBytes = m_transactions[dropped];
+
+    m_bytes.erase(m_bytes.begin(), m_bytes.begin() + droppedBytes);
+    m_transactions.erase(m_transactions.begin(), m_transactions.begin() + dropped);
+    for(size_t &offset : m_transactions) offset -= droppedBytes;
+    m_cursor -= dropped;
+
+}
+
+void EditBuffer::connectLine(const Graph::Node a, const Graph::Node b) {
+    m_commands.push_back(Command{ CONNECT_LINE, a, b });
+}
+
+void EditBuffer::isolateLine(const Graph::Node a, const Graph::Node b) {
+    m_commands.push_back(Command{ ISOLATE_LINE, a, b });
+}
+
+void EditBuffer::fillRect(const Graph::Node a, const Graph::Node b) {
+    m_commands.push_back(Command{ FILL_RECT, a, b });
+}
+
+void EditBuffer::clearRect(const Graph::Node a, const Graph::Node b) {
+    m_commands.push_back(Command{ CLEAR_RECT, a, b });
+}
+
+void EditBuffer::apply(Graph *graph, EditJournal *journal, AppliedEdits *applied) {
+
+    int cols = graph->getCols();
+
+    for(const Command &command : m_commands) {
+
+        if(command.type == FILL_RECT || command.type == CLEAR_RECT) {
+            applyRect(graph, journal, applied, command);
+            continue;
+        }
+
+        vector<Graph::Node> line = traceLine(command.a, command.b, cols);
+
+        if(command.type == CONNECT_LINE) {
+
+            for(size_t i = 1; i < line.size(); i++) {
+
+                // the passage belongs to the left or upper cell of the pair
+                Graph::Node owner = line[i - 1].id < line[i].id ? line[i - 1] : line[i];
+                Graph::Node other = line[i - 1].id < line[i].id ? line[i] : line[i - 1];
+                uint8_t passage = other.y == owner.y ? Graph::RIGHT : Graph::DOWN;
+
+                setPassages(graph, journal, applied, owner, graph->getPassages(owner) | passage);
+
+            }
+
+        } else {
+
+            for(const Graph::Node &node : line) {
+
+                setPassages(graph, journal, applied, node, 0);
+                if(node.x > 0) setPassages(graph, journal, applied, Graph::Node(node.x - 1, node.y, cols), graph->getPassages(Graph::Node(node.x - 1, node.y, cols)) & ~Graph::RIGHT);
+                if(node.y > 0) setPassages(graph, journal, applied, Graph::Node(node.x, node.y - 1, cols), graph->getPassages(Graph::Node(node.x, node.y - 1, cols)) & ~Graph::DOWN);
+
+            }
+
+        }
+
+    }
+
+    m_commands.clear();
+
+}
+
+bool EditBuffer::isEmpty() const {
+    return m_commands.empty();
+}
+
+// 4-connected Bresenham line, so consecutive cells are always neighbors and
+// fast mouse drags that skip cells are interpolated
+vector<Graph::Node> EditBuffer::traceLine(const Graph::Node a, const Graph::Node b, const int cols) {
+
+    vector<Graph::Node> line;
+
+    int dx = std::abs(b.x - a.x);
+    int dy = -std::abs(b.y - a.y);
+    int stepX = a.x < b.x ? 1 : -1;
+    int stepY = a.y < b.y ? 1 : -1;
+    int error = dx + dy;
+    int x = a.x;
+    int y = a.y;
+
+    while(true) {
+
+        line.push_back(Graph::Node(x, y, cols));
+        if(x == b.x && y == b.y) break;
+
+        if(2 * error - dy > dx - 2 * error) {
+            error += dy;
+            x += stepX;
+        } else {
+            error += dx;
+            y += stepY;
+        }
+
+    }
+
+    return line;
+
+}
+
+void EditBuffer::setPassages(Graph *graph, EditJournal *journal, AppliedEdits *applied, const Graph::Node node, const uint8_t passages) {
+
+    uint8_t before = graph->getPassages(node);
+    if(before == passages) return;
+
+    graph->setPassages(node, passages);
+
+    CellDelta delta = CellDelta{ node.id, before, graph->getPassages(node) };
+    journal->record(delta);
+    applied->cells.push_back(delta);
+
+}
+
+// runs on whole passage words: the touched words are snapshotted, the
+// rectangle operation applied and the flipped bits journaled
+void EditBuffer::applyRect(Graph *graph, EditJournal *journal, AppliedEdits *applied, const Command &command) {
+
+    int left = std::max(std::min(command.a.x, command.b.x), 0);
+    int top = std::max(std::min(command.a.y, command.b.y), 0);
+    int right = std::min(std::max(command.a.x, command.b.x) + 1, graph->getCols());
+    int bottom = std::min(std::max(command.a.y, command.b.y) + 1, graph->getRows());
+    if(left >= right || top >= bottom) return;
+
+    // filling also closes the passages owned by the cells left of and above the rectangle
+    int firstRow = std::max(top - 1, 0);
+    int rows = bottom - firstRow;
+    int firstWord = std::max(left - 1, 0) / 64;
+    int words = (right - 1) / 64 - firstWord + 1;
+
+    const Graph::Passage planes[] = { Graph::RIGHT, Graph::DOWN };
+    vector<uint64_t> before((size_t) rows * words * 2);
+
+    for(auto plane = 0; plane < 2; plane++) {
+        for(auto row = 0; row < rows; row++) {
+            for(auto word = 0; word < words; word++) before[((size_t) plane * rows + row) * words + word] = graph->getPassageWord(planes[plane], firstRow + row, firstWord + word);
+        }
+    }
+
+    if(command.type == FILL_RECT) graph->fillRect(left, top, right, bottom);
+    else graph->clearRect(left, top, right, bottom);
+
+    for(auto plane = 0; plane < 2; plane++) {
+
+        uint64_t *flipped = &before[(size_t) plane * rows * words];
+        bool changed = false;
+
+        for(auto row = 0; row < rows; row++) {
+            for(auto word = 0; word < words; word++) {
+                flipped[(size_t) row * words + word] ^= graph->getPassageWord(planes[plane], firstRow + row, firstWord + word);
+                changed |= flipped[(size_t) row * words + word] != 0;
+            }
+        }
+
+        if(changed) journal->recordWords(planes[plane], firstRow, rows, firstWord, words, flipped);
+
+    }
+
+    applied->regions.push_back(EditRegion{ std::max(left - 1, 0), firstRow, std::min(right + 1, graph->getCols()), std::min(bottom + 1, graph->getRows()) });
+
+}
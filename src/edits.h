@@ -0,0 +1,118 @@
+#ifndef EDITS_H
+#define EDITS_H
+
+#include "graph.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+// Change of the passages a single cell owns (see Graph::Passage).
+struct CellDelta {
+    int cell;
+    uint8_t before;
+    uint8_t after;
+};
+
+// Half-open block of cells whose passages changed in bulk.
+struct EditRegion {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+struct AppliedEdits {
+    vector<CellDelta> cells;
+    vector<EditRegion> regions;
+
+    void clear();
+    bool isEmpty() const;
+};
+
+// Undo/redo history stored as packed XOR records, so undoing and redoing a
+// transaction are the same operation. A cell record is one byte of flipped
+// passage bits followed by a 4 byte cell index. A word record (rectangle
+// brushes) stores the flipped passage words of a block of rows, keeping
+// bulk edits at one bit per cell. Records are grouped into transactions,
+// usually one per mouse stroke, and repeated edits of one cell inside a
+// transaction are merged. When the journal outgrows its byte budget the
+// oldest transactions are dropped.
+class EditJournal {
+
+public:
+    EditJournal(const size_t byteBudget);
+
+    void record(const CellDelta delta);
+    void recordWords(const Graph::Passage plane, const int y0, const int rows, const int word0, const int words, const uint64_t *flipped);
+    void commit();
+    void clear();
+
+    bool undo(Graph *graph, AppliedEdits *applied);
+    bool redo(Graph *graph, AppliedEdits *applied);
+
+    bool canUndo() const;
+    bool canRedo() const;
+    size_t getByteSize() const;
+    size_t getTransactionCount() const;
+    // heap bytes including spare capacity; the open transaction's hash
+    // index is estimated from its buckets and nodes
+    size_t getMemoryUsage() const;
+
+private:
+    void discardRedo();
+    void replay(const size_t begin, const size_t end, Graph *graph, AppliedEdits *applied) const;
+    void trim();
+
+    size_t m_byteBudget;
+    TrackedVector<uint8_t, MEMORY_EDITS> m_bytes;
+    // start offsets of every committed transaction followed by the open one
+    TrackedVector<size_t, MEMORY_EDITS> m_transactions;
+    size_t m_cursor;
+    // cell to byte offset of its record in the open transaction
+    std::unordered_map<int, size_t, std::hash<int>, std::equal_to<int>, TrackingAllocator<std::pair<const int, size_t>, MEMORY_EDITS>> m_openDeltas;
+
+};
+
+// Edits collected while handling input and applied to the graph in one
+// batch at the end of the frame.
+class EditBuffer {
+
+public:
+    void connectLine(const Graph::Node a, const Graph::Node b);
+    void isolateLine(const Graph::Node a, const Graph::Node b);
+    void fillRect(const Graph::Node a, const Graph::Node b);
+    void clearRect(const Graph::Node a, const Graph::Node b);
+
+    void apply(Graph *graph, EditJournal *journal, AppliedEdits *applied);
+    bool isEmpty() const;
+
+    static vector<Graph::Node> traceLine(const Graph::Node a, const Graph::Node b, const int cols);
+
+private:
+    enum CommandType : uint8_t {
+        CONNECT_LINE,
+        ISOLATE_LINE,
+        FILL_RECT,
+        CLEAR_RECT
+    };
+
+    struct Command {
+        CommandType type;
+        Graph::Node a;
+        Graph::Node b;
+    };
+
+    void setPassages(Graph *graph, EditJournal *journal, AppliedEdits *applied, const Graph::Node node, const uint8_t passages);
+    void applyRect(Graph *graph, EditJournal *journal, AppliedEdits *applied, const Command &command);
+
+    vector<Command> m_commands;
+
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "flowfield.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+// edits touching more than this share of the cells are cheaper to recompute from scratch
+#define FLOW_FIELD_REPAIR_LIMIT 8
+
+FlowField::FlowField(): m_rows(0), m_cols(0), m_target(0, 0, 1), m_repairedCells(0) {}
+
+void FlowField::compute(const Graph &graph, const Graph::Node target) {
+
+    m_rows = graph.getRows();
+    m_cols = graph.getCols();
+    m_target = target;
+
+    size_t cellCount = (size_t) m_rows * m_cols;
+    m_distance.assign(cellCount, INT_MAX);
+    m_direction.assign(cellCount, NONE);
+    m_repairedCells = cellCount;
+
+    if(cellCount == 0) return;
+
+    // unit costs, so a breadth first sweep settles every cell in order; the
+    // vector doubles as the queue
+    CellList &queue = m_invalidated;
+    queue.clear();
+    queue.push_back(target.id);
+    m_distance[target.id] = 0;
+
+    const int offsets[4] = { -1, -m_cols, 1, m_cols };
+
+    for(size_t head = 0; head < queue.size(); head++) {
+
+        int id = queue[head];
+        uint8_t open = openDirections(graph, id);
+
+        for(auto direction = 0; direction < 4; direction++) {
+
+            int neighbor = id + offsets[direction];
+            if(!(open & (1 << direction)) || m_distance[neighbor] != INT_MAX) continue;
+
+            // the neighbour steps back the opposite way
+            m_distance[neighbor] = m_distance[id] + 1;
+            m_direction[neighbor] = (Direction) ((direction + 2) % 4);
+            queue.push_back(neighbor);
+
+        }
+
+    }
+
+    queue.clear();
+
+}
+
+void FlowField::repair(const Graph &graph, const AppliedEdits &edits) {
+
+    if(isEmpty()) return;
+
+    if(graph.getRows() != m_rows || graph.getCols() != m_cols) {
+        compute(graph, Graph::Node(std::min(m_target.x, graph.getCols() - 1), std::min(m_target.y, graph.getRows() - 1), graph.getCols()));
+        return;
+    }
+
+    size_t cellCount = (size_t) m_rows * m_cols;
+    size_t editedCells = edits.cells.size();
+    for(const EditRegion &region : edits.regions) editedCells += (size_t) (region.x1 - region.x0 + 1) * (region.y1 - region.y0 + 1);
+
+    if(editedCells * FLOW_FIELD_REPAIR_LIMIT > cellCount) {
+        compute(graph, m_target);
+        return;
+    }
+
+    // every cell next to a changed passage, deltas only list the owning cell and regions their inner cells
+    vector<int> changed;
+
+    for(const CellDelta &delta : edits.cells) {
+        changed.push_back(delta.cell);
+        if(delta.cell % m_cols + 1 < m_cols) changed.push_back(delta.cell + 1);
+        if(delta.cell / m_cols + 1 < m_rows) changed.push_back(delta.cell + m_cols);
+    }
+
+    for(const EditRegion &region : edits.regions) {
+        for(auto y = std::max(region.y0 - 1, 0); y <= std::min(region.y1, m_rows - 1); y++) {
+            for(auto x = std::max(region.x0 - 1, 0); x <= std::min(region.x1, m_cols - 1); x++) changed.push_back(y * m_cols + x);
+        }
+    }
+
+    const int offsets[4] = { -1, -m_cols, 1, m_cols };
+
+    m_invalidated.clear();
+    m_open.clear();
+
+    // a cell whose step leads through a closed passage loses its distance, and so does everything behind it
+    for(int id : changed) {
+        if(m_direction[id] != NONE && !(openDirections(graph, id) & (1 << m_direction[id]))) invalidateSubtree(id, &m_invalidated);
+    }
+
+    // invalidated cells restart from their best valid neighbour
+    for(int id : m_invalidated) {
+
+        uint8_t open = openDirections(graph, id);
+
+        for(auto direction = 0; direction < 4; direction++) {
+            int neighbor = id + offsets[direction];
+            if((open & (1 << direction)) && m_distance[neighbor] != INT_MAX) relax(id, m_distance[neighbor] + 1, (Direction) direction);
+        }
+
+    }
+
+    // new passages may be shortcuts for the cells on either side
+    for(int id : changed) {
+
+        if(m_distance[id] == INT_MAX) continue;
+
+        uint8_t open = openDirections(graph, id);
+
+        for(auto direction = 0; direction < 4; direction++) {
+            if(open & (1 << direction)) relax(id + offsets[direction], m_distance[id] + 1, (Direction) ((direction + 2) % 4));
+        }
+
+    }
+
+    m_repairedCells = m_invalidated.size();
+    propagate(graph);
+
+}
+
+void FlowField::clear() {
+
+    m_rows = 0;
+    m_cols = 0;
+    m_distance.clear();
+    m_direction.clear();
+    m_repairedCells = 0;
+
+}
+
+Graph::Node FlowField::next(const Graph::Node node) const {
+
+    switch(m_direction[node.id]) {
+        case LEFT:
+            return Graph::Node(node.x - 1, node.y, m_cols);
+        case UP:
+            return Graph::Node(node.x, node.y - 1, m_cols);
+        case RIGHT:
+            return Graph::Node(node.x + 1, node.y, m_cols);
+        case DOWN:
+            return Graph::Node(node.x, node.y + 1, m_cols);
+        default:
+            return node;
+    }
+
+}
+
+// from to the target, empty if the target cannot be reached
+vector<Graph::Node> FlowField::getPath(const Graph::Node from) const {
+
+    vector<Graph::Node> path;
+    if(m_distance[from.id] == INT_MAX) return path;
+
+    path.reserve(m_distance[from.id] + 1);
+    path.push_back(from);
+
+    for(Graph::Node node = from; node != m_target;) {
+        node = next(node);
+        path.push_back(node);
+    }
+
+    return path;
+
+}
+
+FlowField::Direction FlowField::getDirection(const Graph::Node node) const {
+    return m_direction[node.id];
+}
+
+int FlowField::getDistance(const Graph::Node node) const {
+    return m_distance[node.id] == INT_MAX ? -1 : m_distance[node.id];
+}
+
+int FlowField::getMaxDistance() const {
+
+    int maxDistance = 0;
+    for(int distance : m_distance) if(distance != INT_MAX) maxDistance = std::max(maxDistance, distance);
+
+    return maxDistance;
+
+}
+
+bool FlowField::isEmpty() const {
+    return m_distance.empty();
+}
+
+Graph::Node FlowField::getTarget() const {
+    return m_target;
+}
+
+int FlowField::getRows() const {
+    return m_rows;
+}
+
+int FlowField::getCols() const {
+    return m_cols;
+}
+
+size_t FlowField::getRepairedCells() const {
+    return m_repairedCells;
+}
+
+size_t FlowField::getMemoryUsage() const {
+    return getCapacityBytes(m_distance) + getCapacityBytes(m_direction) + getCapacityBytes(m_open) + getCapacityBytes(m_invalidated);
+}
+
+// bit d set when the passage towards offsets[d] is open
+uint8_t FlowField::openDirections(const Graph &graph, const int id) const {
+
+    int x = id % m_cols;
+    int y = id / m_cols;
+    uint8_t open = 0;
+
+    if(x > 0 && (graph.getPassages(Graph::Node(x - 1, y, m_cols)) & Graph::RIGHT)) open |= 1 << LEFT;
+    if(y > 0 && (graph.getPassages(Graph::Node(x, y - 1, m_cols)) & Graph::DOWN)) open |= 1 << UP;
+
+    uint8_t passages = graph.getPassages(Graph::Node(x, y, m_cols));
+    if(passages & Graph::RIGHT) open |= 1 << RIGHT;
+    if(passages & Graph::DOWN) open |= 1 << DOWN;
+
+    return open;
+
+}
+
+// children are the neighbours whose direction points back at a cell
+void FlowField::invalidateSubtree(const int root, CellList *invalidated) {
+
+    size_t begin = invalidated->size();
+
+    m_distance[root] = INT_MAX;
+    m_direction[root] = NONE;
+    invalidated->push_back(root);
+
+    const int offsets[4] = { -1, -m_cols, 1, m_cols };
+
+    for(size_t i = begin; i < invalidated->size(); i++) {
+
+        int id = (*invalidated)[i];
+        int x = id % m_cols;
+        int y = id / m_cols;
+
+        for(auto direction = 0; direction < 4; direction++) {
+
+            if((direction == LEFT && x == 0) || (direction == UP && y == 0) || (direction == RIGHT && x + 1 == m_cols) || (direction == DOWN && y + 1 == m_rows)) continue;
+
+            int child = id + offsets[direction];
+            if(m_distance[child] == INT_MAX || m_direction[child] != (direction + 2) % 4) continue;
+
+            m_distance[child] = INT_MAX;
+            m_direction[child] = NONE;
+            invalidated->push_back(child);
+
+        }
+
+    }
+
+}
+
+void FlowField::relax(const int id, const int distance, const Direction direction) {
+
+    if(id == m_target.id || distance >= m_distance[id]) return;
+
+    m_distance[id] = distance;
+    m_direction[id] = direction;
+    m_open.push_back(std::make_pair(distance, id));
+    std::push_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+
+}
+
+void FlowField::propagate(const Graph &graph) {
+
+    const int offsets[4] = { -1, -m_cols, 1, m_cols };
+
+    while(!m_open.empty()) {
+
+        std::pop_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+        QueueEntry entry = m_open.back();
+        m_open.pop_back();
+
+        int id = entry.second;
+        if(entry.first > m_distance[id]) continue;
+
+        uint8_t open = openDirections(graph, id);
+
+        for(auto direction = 0; direction < 4; direction++) {
+            if(open & (1 << direction)) relax(id + offsets[direction], entry.first + 1, (Direction) ((direction + 2) % 4));
+        }
+
+    }
+
+}
@@ -0,0 +1,84 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "edits.h"
+#include "graph.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+// Distance field towards a single target plus the direction each cell
+// takes to get one step closer, so any number of agents sharing the target
+// follow it in O(1) per step instead of running their own searches.
+// Directions form a shortest path tree rooted at the target. After edits
+// only the affected part is repaired: a removed tree passage invalidates
+// the subtree hanging below it, which is then refilled from its valid
+// border together with any new shortcuts, all in one Dijkstra pass.
+class FlowField {
+
+public:
+    // same order as the neighbour offsets { -1, -cols, 1, cols }
+    enum Direction : uint8_t {
+        LEFT,
+        UP,
+        RIGHT,
+        DOWN,
+        NONE
+    };
+
+    FlowField();
+
+    void compute(const Graph &graph, const Graph::Node target);
+
+    // brings the field up to date with edits already applied to the graph;
+    // falls back to compute() for a resized graph or edits covering much of it
+    void repair(const Graph &graph, const AppliedEdits &edits);
+
+    void clear();
+
+    // the neighbour one step closer to the target; the node itself at the
+    // target and wherever the target cannot be reached
+    Graph::Node next(const Graph::Node node) const;
+    vector<Graph::Node> getPath(const Graph::Node from) const;
+
+    Direction getDirection(const Graph::Node node) const;
+    // -1 where the target cannot be reached
+    int getDistance(const Graph::Node node) const;
+    int getMaxDistance() const;
+    bool isEmpty() const;
+    Graph::Node getTarget() const;
+    int getRows() const;
+    int getCols() const;
+
+    // cells whose distance the last repair had to recompute
+    size_t getRepairedCells() const;
+    size_t getMemoryUsage() const;
+
+private:
+    typedef std::pair<int, int> QueueEntry;
+    typedef TrackedVector<int, MEMORY_FLOW_FIELD> CellList;
+
+    uint8_t openDirections(const Graph &graph, const int id) const;
+    void invalidateSubtree(const int root, CellList *invalidated);
+    void relax(const int id, const int distance, const Direction direction);
+    void propagate(const Graph &graph);
+
+    int m_rows;
+    int m_cols;
+    Graph::Node m_target;
+    TrackedVector<int, MEMORY_FLOW_FIELD> m_distance;
+    TrackedVector<Direction, MEMORY_FLOW_FIELD> m_direction;
+    size_t m_repairedCells;
+
+    // repair scratch, kept between calls
+    TrackedVector<QueueEntry, MEMORY_FLOW_FIELD> m_open;
+    CellList m_invalidated;
+
+};
+
+#endif
@@ -1,76 +1,334 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
+
+#define WORD_BITS 64
+
+// mask with bits [from, to) set, 0 <= from <= to <= 64
+uint64_t bitRange(const int from, const int to) {
+
+    uint64_t upper = to >= WORD_BITS ? ~0ULL : (1ULL << to) - 1;
+    uint64_t lower = (1ULL << from) - 1;
+
+    return upper & ~lower;
+
+}
 
 Graph::Node::Node(const int gridX, const int gridY, const int cols): id(gridY * cols + gridX), x(gridX), y(gridY) {}
 
-Graph::Graph(const int rows, const int cols) {
+Graph::Graph(const int rows, const int cols): m_rows(rows), m_cols(cols), m_wordsPerRow((cols + WORD_BITS - 1) / WORD_BITS) {
 
-    m_adjList = std::make_unique<map<Node, vector<Node>>>();
+    // copying a band clears its flag, so the table must not grow while filled
+    m_chunks.reserve((m_rows + GRAPH_CHUNK_ROWS - 1) / GRAPH_CHUNK_ROWS);
+    m_bands.reserve(m_chunks.capacity());
 
-    for(auto x = 0; x < cols; x++) {
-        for(auto y = 0; y < rows; y++) {
+    for(auto y = 0; y < m_rows; y += GRAPH_CHUNK_ROWS) addChunk(makeChunk(std::min(GRAPH_CHUNK_ROWS, m_rows - y)), true);
 
-            Node node = Node(x, y, cols);
-            m_adjList->insert(std::make_pair(node, vector<Node>()));
+}
 
-        }
+// the planes must already be padded and masked the way this class keeps its own
+Graph::Graph(const int rows, const int cols, std::shared_ptr<const void> storage, const uint64_t *right, const uint64_t *down): m_rows(rows), m_cols(cols), m_wordsPerRow((cols + WORD_BITS - 1) / WORD_BITS) {
+
+    m_chunks.reserve((m_rows + GRAPH_CHUNK_ROWS - 1) / GRAPH_CHUNK_ROWS);
+    m_bands.reserve(m_chunks.capacity());
+
+    for(auto y = 0; y < m_rows; y += GRAPH_CHUNK_ROWS) {
+        size_t offset = (size_t) y * m_wordsPerRow;
+        addChunk(std::make_shared<Chunk>(Chunk { std::min(GRAPH_CHUNK_ROWS, m_rows - y), {}, storage, right + offset, down + offset }), false);
     }
 
 }
 
-void Graph::resize(const int rows, const int cols) {
+Graph::Graph(const Graph &other): m_rows(other.m_rows), m_cols(other.m_cols), m_wordsPerRow(other.m_wordsPerRow), m_chunks(other.m_chunks), m_bands(other.m_bands) {
+
+    for(Band &band : other.m_bands) band.owned.store(false, std::memory_order_relaxed);
 
-    std::unique_ptr<map<Node, vector<Node>>> newAdjList = std::make_unique<map<Node, vector<Node>>>();
+}
 
-    for(auto x = 0; x < cols; x++) {
-        for(auto y = 0; y < rows; y++) {
+Graph &Graph::operator=(const Graph &other) {
 
-            Node node = Node(x, y, cols);
-            newAdjList->insert(std::make_pair(node, vector<Node>()));
+    if(this != &other) *this = Graph(other);
 
-        }
-    }
+    return *this;
 
-    for(const auto &entry : *m_adjList) {
+}
 
-        Node key = entry.first;
-        auto it = newAdjList->find(key);
+void Graph::resize(const int rows, const int cols) {
 
-        if(it == newAdjList->end()) continue;
+    Graph resized = Graph(rows, cols);
 
-        newAdjList->at(key) = m_adjList->at(key);
+    int keptRows = std::min(rows, m_rows);
+    int keptWords = std::min(resized.m_wordsPerRow, m_wordsPerRow);
+    vector<uint64_t> row = vector<uint64_t>(resized.m_wordsPerRow, 0);
 
+    // setPassageRow drops passages that now lead out of the grid or into the padding
+    for(auto y = 0; y < keptRows; y++) {
+        for(Passage plane : { RIGHT, DOWN }) {
+            std::copy_n(getPassageRow(plane, y), keptWords, row.begin());
+            resized.setPassageRow(plane, y, row.data());
+        }
     }
 
-    m_adjList = std::move(newAdjList);
+    *this = std::move(resized);
 
 }
 
 void Graph::addEdge(const Node a, const Node b) {
 
-    m_adjList->at(a).push_back(b);
-    m_adjList->at(b).push_back(a);
+    const Node &owner = a.id < b.id ? a : b;
+    const Node &other = a.id < b.id ? b : a;
+
+    if(other.y == owner.y && other.x == owner.x + 1) setBit(RIGHT, owner.x, owner.y, true);
+    else if(other.x == owner.x && other.y == owner.y + 1) setBit(DOWN, owner.x, owner.y, true);
     
 }
 
+void Graph::removeEdge(const Node a, const Node b) {
+
+    const Node &owner = a.id < b.id ? a : b;
+    const Node &other = a.id < b.id ? b : a;
+
+    if(other.y == owner.y && other.x == owner.x + 1) setBit(RIGHT, owner.x, owner.y, false);
+    else if(other.x == owner.x && other.y == owner.y + 1) setBit(DOWN, owner.x, owner.y, false);
+
+}
+
+// the rows are fetched once rather than per bit, the brush runs this for every painted cell
 void Graph::removeAllNeighbors(const Node node) {
-    
-    vector<Node> neighbors = m_adjList->at(node);
 
-    if(neighbors.empty()) return;
+    if(node.x < 0 || node.y < 0 || node.x >= m_cols || node.y >= m_rows) return;
+
+    int word = node.x / WORD_BITS;
+    uint64_t bit = 1ULL << (node.x % WORD_BITS);
+    uint64_t *right = getMutableRow(RIGHT, node.y);
+
+    right[word] &= ~bit;
+    if(node.x > 0) right[(node.x - 1) / WORD_BITS] &= ~(1ULL << ((node.x - 1) % WORD_BITS));
+    getMutableRow(DOWN, node.y)[word] &= ~bit;
+    if(node.y > 0) getMutableRow(DOWN, node.y - 1)[word] &= ~bit;
+
+}
 
-    for(const Node &neihgbor : neighbors) {
+// closes every passage of every cell in [x0, x1) x [y0, y1), including those leading out of the rectangle
+void Graph::fillRect(const int x0, const int y0, const int x1, const int y1) {
 
-        auto nodePos = std::find(m_adjList->at(neihgbor).begin(), m_adjList->at(neihgbor).end(), node);
-        if(nodePos != m_adjList->at(neihgbor).end()) m_adjList->at(neihgbor).erase(nodePos);
+    int left = std::max(x0, 0);
+    int top = std::max(y0, 0);
+    int right = std::min(x1, m_cols);
+    int bottom = std::min(y1, m_rows);
+    if(left >= right || top >= bottom) return;
 
+    for(auto y = top; y < bottom; y++) {
+        setSpan(RIGHT, y, std::max(left - 1, 0), right, false);
+        setSpan(DOWN, y, left, right, false);
     }
 
-    m_adjList->at(node) = vector<Node>();
+    if(top > 0) setSpan(DOWN, top - 1, left, right, false);
+
+}
+
+// opens every passage between two cells inside [x0, x1) x [y0, y1)
+void Graph::clearRect(const int x0, const int y0, const int x1, const int y1) {
+
+    int left = std::max(x0, 0);
+    int top = std::max(y0, 0);
+    int right = std::min(x1, m_cols);
+    int bottom = std::min(y1, m_rows);
+    if(left >= right || top >= bottom) return;
+
+    for(auto y = top; y < bottom; y++) {
+        setSpan(RIGHT, y, left, right - 1, true);
+        if(y < bottom - 1) setSpan(DOWN, y, left, right, true);
+    }
 
 }
 
 vector<Graph::Node> Graph::getNeighbors(const Node node) const {
-    return m_adjList->at(node);
+
+    vector<Node> neighbors;
+
+    if(node.x > 0 && getBit(RIGHT, node.x - 1, node.y)) neighbors.push_back(Node(node.x - 1, node.y, m_cols));
+    if(node.y > 0 && getBit(DOWN, node.x, node.y - 1)) neighbors.push_back(Node(node.x, node.y - 1, m_cols));
+    if(getBit(RIGHT, node.x, node.y)) neighbors.push_back(Node(node.x + 1, node.y, m_cols));
+    if(getBit(DOWN, node.x, node.y)) neighbors.push_back(Node(node.x, node.y + 1, m_cols));
+
+    return neighbors;
+
+}
+
+bool Graph::hasEdge(const Node a, const Node b) const {
+
+    const Node &owner = a.id < b.id ? a : b;
+    const Node &other = a.id < b.id ? b : a;
+
+    if(owner.x < 0 || owner.y < 0 || owner.x >= m_cols || owner.y >= m_rows) return false;
+
+    if(other.y == owner.y && other.x == owner.x + 1) return getBit(RIGHT, owner.x, owner.y);
+    if(other.x == owner.x && other.y == owner.y + 1) return getBit(DOWN, owner.x, owner.y);
+
+    return false;
+
+}
+
+uint8_t Graph::getPassages(const Node node) const {
+    return (getBit(RIGHT, node.x, node.y) ? RIGHT : 0) | (getBit(DOWN, node.x, node.y) ? DOWN : 0);
+}
+
+void Graph::setPassages(const Node node, const uint8_t passages) {
+
+    setBit(RIGHT, node.x, node.y, (passages & RIGHT) && node.x + 1 < m_cols);
+    setBit(DOWN, node.x, node.y, (passages & DOWN) && node.y + 1 < m_rows);
+
+}
+
+uint64_t Graph::getPassageWord(const Passage plane, const int y, const int word) const {
+    return getPassageRow(plane, y)[word];
+}
+
+void Graph::xorPassageWord(const Passage plane, const int y, const int word, const uint64_t mask) {
+    getMutableRow(plane, y)[word] ^= mask;
+}
+
+// copies a full row of words, dropping bits that would lead out of the grid or sit in the padding
+void Graph::setPassageRow(const Passage plane, const int y, const uint64_t *words) {
+
+    std::copy_n(words, m_wordsPerRow, getMutableRow(plane, y));
+
+    if(plane == RIGHT) setSpan(RIGHT, y, m_cols - 1, m_wordsPerRow * WORD_BITS, false);
+    else if(y == m_rows - 1) setSpan(DOWN, y, 0, m_wordsPerRow * WORD_BITS, false);
+    else setSpan(DOWN, y, m_cols, m_wordsPerRow * WORD_BITS, false);
+
+}
+
+int Graph::getWordsPerRow() const {
+    return m_wordsPerRow;
+}
+
+int Graph::getRows() const {
+    return m_rows;
+}
+
+int Graph::getCols() const {
+    return m_cols;
+}
+
+bool Graph::isShared() const {
+
+    for(const std::shared_ptr<Chunk> &chunk : m_chunks) {
+        if(chunk->storage) return true;
+    }
+
+    return false;
+
+}
+
+size_t Graph::getMemoryUsage() const {
+
+    size_t bytes = getCapacityBytes(m_chunks) + getCapacityBytes(m_bands);
+    for(const std::shared_ptr<Chunk> &chunk : m_chunks) bytes += getCapacityBytes(chunk->words);
+
+    return bytes;
+
+}
+
+void Graph::addChunk(std::shared_ptr<Chunk> chunk, const bool owned) {
+
+    m_bands.emplace_back(chunk->right, chunk->down, owned);
+    m_chunks.push_back(std::move(chunk));
+
+}
+
+std::shared_ptr<Graph::Chunk> Graph::makeChunk(const int rows) const {
+
+    std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+    chunk->rows = rows;
+    chunk->words.assign((size_t) 2 * rows * m_wordsPerRow, 0);
+    chunk->right = chunk->words.data();
+    chunk->down = chunk->words.data() + (size_t) rows * m_wordsPerRow;
+
+    return chunk;
+
+}
+
+// writes to a band this graph owns go straight through
+void Graph::detach(const int index) {
+
+    if(!m_bands[index].owned.load(std::memory_order_relaxed)) cloneChunk(index);
+
+}
+
+// a band some copy still holds, or one in mapped memory, is cloned before the first write
+void Graph::cloneChunk(const int index) {
+
+    std::shared_ptr<Chunk> &chunk = m_chunks[index];
+
+    if(!chunk->storage && chunk.use_count() == 1) {
+        // the last other owner released the band after its final read; see that before writing over it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_bands[index].owned.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    std::shared_ptr<Chunk> copy = makeChunk(chunk->rows);
+    size_t words = (size_t) chunk->rows * m_wordsPerRow;
+    std::copy_n(chunk->right, words, copy->words.begin());
+    std::copy_n(chunk->down, words, copy->words.begin() + words);
+    chunk = std::move(copy);
+    m_bands[index].right = chunk->right;
+    m_bands[index].down = chunk->down;
+    m_bands[index].owned.store(true, std::memory_order_relaxed);
+
+}
+
+// an owned band's rows are the chunk's own words, only handed out read-only by getPassageRow
+uint64_t *Graph::getMutableRow(const Passage plane, const int y) {
+
+    int index = y >> GRAPH_CHUNK_ROW_BITS;
+    detach(index);
+
+    const Band &band = m_bands[index];
+
+    return const_cast<uint64_t*>(plane == RIGHT ? band.right : band.down) + (size_t) (y & (GRAPH_CHUNK_ROWS - 1)) * m_wordsPerRow;
+
+}
+
+bool Graph::getBit(const Passage plane, const int x, const int y) const {
+
+    if(x < 0 || y < 0 || x >= m_cols || y >= m_rows) return false;
+
+    return (getPassageRow(plane, y)[x / WORD_BITS] >> (x % WORD_BITS)) & 1;
+
+}
+
+void Graph::setBit(const Passage plane, const int x, const int y, const bool value) {
+
+    if(x < 0 || y < 0 || x >= m_cols || y >= m_rows) return;
+
+    uint64_t &word = getMutableRow(plane, y)[x / WORD_BITS];
+    uint64_t bit = 1ULL << (x % WORD_BITS);
+
+    word = value ? word | bit : word & ~bit;
+
+}
+
+// sets or clears bits [x0, x1) of one row a word at a time
+void Graph::setSpan(const Passage plane, const int y, const int x0, const int x1, const bool value) {
+
+    if(x0 >= x1 || y < 0 || y >= m_rows) return;
+
+    uint64_t *row = getMutableRow(plane, y);
+    int firstWord = x0 / WORD_BITS;
+    int lastWord = (x1 - 1) / WORD_BITS;
+
+    for(auto word = firstWord; word <= lastWord; word++) {
+
+        int from = word == firstWord ? x0 % WORD_BITS : 0;
+        int to = word == lastWord ? (x1 - 1) % WORD_BITS + 1 : WORD_BITS;
+        uint64_t mask = bitRange(from, to);
+
+        row[word] = value ? row[word] | mask : row[word] & ~mask;
+
+    }
+
 }
\ No newline at end of file
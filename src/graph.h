@@ -1,12 +1,34 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#include <map>
+#include "memory.h"
+
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
-using std::map, std::vector;
+using std::vector;
+
+// rows per copy-on-write chunk, a power of two
+#define GRAPH_CHUNK_ROW_BITS 5
+#define GRAPH_CHUNK_ROWS (1 << GRAPH_CHUNK_ROW_BITS)
 
+// 4-connected grid graph. Every cell owns the passages to its right and
+// lower neighbor; both are stored as bit planes with one bit per cell and
+// each row padded to whole 64 bit words, so bulk edits touch a word of 64
+// cells at a time.
+//
+// The planes are split into bands of GRAPH_CHUNK_ROWS rows held by shared
+// pointers. Copying a graph only copies the band table, and a band another
+// copy still holds is cloned on its first modification, so a copy costs
+// the bands edited afterwards rather than the whole grid. Each band carries
+// an owned flag, cleared on both sides of a copy, so writes to a band this
+// graph already owns only test the flag. Bands may also
+// live in read-only memory owned by someone else (a mapped maze file) and
+// are copied the same way. Copies may be read, copied and destroyed on
+// other threads while the original is edited.
 class Graph {
 
 public:
@@ -22,16 +44,91 @@ public:
         friend bool operator!=(const Node &a, const Node &b) { return !operator==(a, b); }
     };
 
+    enum Passage : uint8_t {
+        RIGHT = 1,
+        DOWN = 2
+    };
+
     Graph(const int rows, const int cols);
+    Graph(const int rows, const int cols, std::shared_ptr<const void> storage, const uint64_t *right, const uint64_t *down);
+    // shares every band; the next write to one clones it, on whichever side writes
+    Graph(const Graph &other);
+    Graph &operator=(const Graph &other);
+    Graph(Graph &&other) = default;
+    Graph &operator=(Graph &&other) = default;
     void resize(const int rows, const int cols);
     void addEdge(const Node a, const Node b);
+    void removeEdge(const Node a, const Node b);
     void removeAllNeighbors(const Node node); 
 
+    void fillRect(const int x0, const int y0, const int x1, const int y1);
+    void clearRect(const int x0, const int y0, const int x1, const int y1);
+
     vector<Node> getNeighbors(const Node node) const;
+    bool hasEdge(const Node a, const Node b) const;
+    uint8_t getPassages(const Node node) const;
+    void setPassages(const Node node, const uint8_t passages);
+
+    uint64_t getPassageWord(const Passage plane, const int y, const int word) const;
+    void xorPassageWord(const Passage plane, const int y, const int word, const uint64_t mask);
+    const uint64_t *getPassageRow(const Passage plane, const int y) const;
+    void setPassageRow(const Passage plane, const int y, const uint64_t *words);
+    int getWordsPerRow() const;
+    int getRows() const;
+    int getCols() const;
+    // whether any band still lives in mapped memory
+    bool isShared() const;
+    // heap bytes of the owned bands, including those shared with copies; mapped bands belong to the file
+    size_t getMemoryUsage() const;
 
 private:
-    std::unique_ptr<map<Node, vector<Node>>> m_adjList;
+    struct Chunk {
+        int rows;
+        // right plane rows followed by down plane rows, empty while mapped
+        TrackedVector<uint64_t, MEMORY_GRAPH> words;
+        // keeps mapped planes alive, empty while the words are owned
+        std::shared_ptr<const void> storage;
+        const uint64_t *right;
+        const uint64_t *down;
+    };
+
+    // the first right and down row of a chunk, so reads skip the shared pointer. The owned
+    // flag says no other graph holds the chunk and it is not mapped; it sits next to the rows
+    // so a write reads a single entry. Copies start out not owning, and as copies of a graph
+    // may be made from several threads at once, each clears its source's flags atomically.
+    struct Band {
+        const uint64_t *right;
+        const uint64_t *down;
+        std::atomic<bool> owned;
+
+        Band(const uint64_t *rightRows, const uint64_t *downRows, const bool isOwned): right(rightRows), down(downRows), owned(isOwned) {}
+        Band(const Band &other): right(other.right), down(other.down), owned(false) {}
+    };
+
+    std::shared_ptr<Chunk> makeChunk(const int rows) const;
+    void addChunk(std::shared_ptr<Chunk> chunk, const bool owned);
+    void detach(const int chunk);
+    void cloneChunk(const int chunk);
+    uint64_t *getMutableRow(const Passage plane, const int y);
+    bool getBit(const Passage plane, const int x, const int y) const;
+    void setBit(const Passage plane, const int x, const int y, const bool value);
+    void setSpan(const Passage plane, const int y, const int x0, const int x1, const bool value);
+
+    int m_rows;
+    int m_cols;
+    int m_wordsPerRow;
+    vector<std::shared_ptr<Chunk>> m_chunks;
+    mutable vector<Band> m_bands;
 
 };
 
+// inline, as every neighbour test of the search goes through it
+inline const uint64_t *Graph::getPassageRow(const Passage plane, const int y) const {
+
+    const Band &band = m_bands[y >> GRAPH_CHUNK_ROW_BITS];
+
+    return (plane == RIGHT ? band.right : band.down) + (size_t) (y & (GRAPH_CHUNK_ROWS - 1)) * m_wordsPerRow;
+
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include "heatmap.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#define HEAT_UNSEEN 0.0f
+#define HEAT_FRONTIER 1.0f
+#define HEAT_VISITED_BASE 2.0f
+#define HEAT_OPACITY 0.6f
+
+const char *HEATMAP_VERTEX_SHADER = R"(
+#version 330 core
+layout(location = 0) in vec2 position;
+uniform vec4 screenRect;
+uniform vec2 displayPos;
+uniform vec2 displaySize;
+out vec2 uv;
+void main() {
+    vec2 screen = mix(screenRect.xy, screenRect.zw, position);
+    vec2 ndc = (screen - displayPos) / displaySize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    uv = position;
+}
+)";
+
+const char *HEATMAP_FRAGMENT_SHADER = R"(
+#version 330 core
+in vec2 uv;
+uniform sampler2D heat;
+uniform float maxDistance;
+uniform float opacity;
+out vec4 color;
+void main() {
+    float value = texture(heat, uv).r;
+    if(value < 0.5) discard;
+    if(value < 1.5) {
+        color = vec4(1.0, 0.3, 0.8, opacity);
+        return;
+    }
+    float t = clamp((value - 2.0) / max(maxDistance, 1.0), 0.0, 1.0);
+    vec3 jet = clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+    color = vec4(jet, opacity);
+}
+)";
+
+GLuint compileShader(const GLenum type, const char *source) {
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    if(!status) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cout << "Failed to compile heatmap shader: " << log << std::endl;
+    }
+
+    return shader;
+
+}
+
+Heatmap::Heatmap(): m_rows(0), m_cols(0), m_supported(false), m_maxDistance(0), m_firstDirtyRow(INT_MAX), m_lastDirtyRow(-1),
+    m_texture(0), m_pixelBuffers{ 0, 0 }, m_pixelBufferIndex(0), m_program(0), m_vertexArray(0), m_vertexBuffer(0) {
+
+    createProgram();
+
+    glGenTextures(1, &m_texture);
+    glGenBuffers(2, m_pixelBuffers);
+
+}
+
+Heatmap::~Heatmap() {
+
+    glDeleteTextures(1, &m_texture);
+    glDeleteBuffers(2, m_pixelBuffers);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteVertexArrays(1, &m_vertexArray);
+    glDeleteProgram(m_program);
+
+}
+
+void Heatmap::resize(const int rows, const int cols) {
+
+    m_rows = rows;
+    m_cols = cols;
+
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    // grids beyond the texture limit fall back to the LOD pyramid
+    m_supported = rows <= maxTextureSize && cols <= maxTextureSize;
+    if(!m_supported) {
+        m_cells = TrackedVector<float, MEMORY_RENDERING>();
+        m_dirtyRows = TrackedVector<bool, MEMORY_RENDERING>();
+        return;
+    }
+
+    m_cells.assign((size_t) rows * cols, HEAT_UNSEEN);
+    m_dirtyRows.assign(rows, true);
+    m_firstDirtyRow = 0;
+    m_lastDirtyRow = rows - 1;
+    m_maxDistance = 0;
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cols, rows, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for(GLuint pixelBuffer : m_pixelBuffers) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_cells.size() * sizeof(float), NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+}
+
+void Heatmap::clear() {
+
+    if(!m_supported) return;
+
+    std::fill(m_cells.begin(), m_cells.end(), HEAT_UNSEEN);
+    std::fill(m_dirtyRows.begin(), m_dirtyRows.end(), true);
+    m_firstDirtyRow = 0;
+    m_lastDirtyRow = m_rows - 1;
+    m_maxDistance = 0;
+
+}
+
+void Heatmap::setUnseen(const int x, const int y) {
+    set(x, y, HEAT_UNSEEN);
+}
+
+void Heatmap::setFrontier(const int x, const int y) {
+    set(x, y, HEAT_FRONTIER);
+}
+
+void Heatmap::setVisited(const int x, const int y, const int distance) {
+
+    set(x, y, HEAT_VISITED_BASE + distance);
+    m_maxDistance = std::max(m_maxDistance, (float) distance);
+
+}
+
+void Heatmap::set(const int x, const int y, const float value) {
+
+    if(!m_supported || x < 0 || y < 0 || x >= m_cols || y >= m_rows) return;
+
+    m_cells[(size_t) y * m_cols + x] = value;
+    m_dirtyRows[y] = true;
+    m_firstDirtyRow = std::min(m_firstDirtyRow, y);
+    m_lastDirtyRow = std::max(m_lastDirtyRow, y);
+
+}
+
+void Heatmap::upload() {
+
+    if(!m_supported || m_lastDirtyRow < m_firstDirtyRow) return;
+
+    size_t rowBytes = (size_t) m_cols * sizeof(float);
+    size_t offset = m_firstDirtyRow * rowBytes;
+    size_t length = (size_t) (m_lastDirtyRow - m_firstDirtyRow + 1) * rowBytes;
+
+    // write into the buffer the GPU did not use last frame
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffers[m_pixelBufferIndex]);
+    m_pixelBufferIndex ^= 1;
+
+    char *mapped = (char *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+    if(!mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+
+    for(auto row = m_firstDirtyRow; row <= m_lastDirtyRow; row++) {
+        if(!m_dirtyRows[row]) continue;
+        std::memcpy(mapped + (row - m_firstDirtyRow) * rowBytes, &m_cells[(size_t) row * m_cols], rowBytes);
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // one transfer per contiguous run of dirty rows, sourced from the buffer;
+    // the unpack offset counts from the start of the buffer, not the mapped range
+    int row = m_firstDirtyRow;
+
+    while(row <= m_lastDirtyRow) {
+
+        if(!m_dirtyRows[row]) {
+            row++;
+            continue;
+        }
+
+        int runStart = row;
+        while(row <= m_lastDirtyRow && m_dirtyRows[row]) m_dirtyRows[row++] = false;
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, runStart, m_cols, row - runStart, GL_RED, GL_FLOAT, (const void *) (offset + (runStart - m_firstDirtyRow) * rowBytes));
+
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_firstDirtyRow = INT_MAX;
+    m_lastDirtyRow = -1;
+
+}
+
+void Heatmap::draw(ImDrawList *drawList, const ImVec2 gridUpperLeft, const ImVec2 gridBottomRight) {
+
+    if(!m_supported || m_program == 0) return;
+
+    m_screenUpperLeft = gridUpperLeft;
+    m_screenBottomRight = gridBottomRight;
+
+    drawList->AddCallback(renderCallback, this);
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+
+}
+
+// runs inside ImGui_ImplOpenGL3_RenderDrawData with the backend's state bound
+void Heatmap::renderCallback(const ImDrawList *drawList, const ImDrawCmd *command) {
+
+    (void) drawList;
+
+    Heatmap *heatmap = (Heatmap *) command->UserCallbackData;
+    ImDrawData *drawData = ImGui::GetDrawData();
+
+    int framebufferHeight = (int) (drawData->DisplaySize.y * drawData->FramebufferScale.y);
+    ImVec2 clipMin = ImVec2((command->ClipRect.x - drawData->DisplayPos.x) * drawData->FramebufferScale.x, (command->ClipRect.y - drawData->DisplayPos.y) * drawData->FramebufferScale.y);
+    ImVec2 clipMax = ImVec2((command->ClipRect.z - drawData->DisplayPos.x) * drawData->FramebufferScale.x, (command->ClipRect.w - drawData->DisplayPos.y) * drawData->FramebufferScale.y);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor((int) clipMin.x, (int) (framebufferHeight - clipMax.y), (int) (clipMax.x - clipMin.x), (int) (clipMax.y - clipMin.y));
+
+    glUseProgram(heatmap->m_program);
+    glUniform4f(glGetUniformLocation(heatmap->m_program, "screenRect"), heatmap->m_screenUpperLeft.x, heatmap->m_screenUpperLeft.y, heatmap->m_screenBottomRight.x, heatmap->m_screenBottomRight.y);
+    glUniform2f(glGetUniformLocation(heatmap->m_program, "displayPos"), drawData->DisplayPos.x, drawData->DisplayPos.y);
+    glUniform2f(glGetUniformLocation(heatmap->m_program, "displaySize"), drawData->DisplaySize.x, drawData->DisplaySize.y);
+    glUniform1f(glGetUniformLocation(heatmap->m_program, "maxDistance"), heatmap->m_maxDistance);
+    glUniform1f(glGetUniformLocation(heatmap->m_program, "opacity"), HEAT_OPACITY);
+    glUniform1i(glGetUniformLocation(heatmap->m_program, "heat"), 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heatmap->m_texture);
+    glBindVertexArray(heatmap->m_vertexArray);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+}
+
+void Heatmap::createProgram() {
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, HEATMAP_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, HEATMAP_FRAGMENT_SHADER);
+
+    m_program = glCreateProgram();
+    glAttachShader(m_program, vertexShader);
+    glAttachShader(m_program, fragmentShader);
+    glLinkProgram(m_program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint status;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+
+    if(!status) {
+        std::cout << "Failed to link heatmap shader." << std::endl;
+        glDeleteProgram(m_program);
+        m_program = 0;
+    }
+
+    const float quad[] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+
+    glGenVertexArrays(1, &m_vertexArray);
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindVertexArray(m_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *) 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+}
+
+bool Heatmap::isSupported() const {
+    return m_supported;
+}
+
+int Heatmap::getRows() const {
+    return m_rows;
+}
+
+int Heatmap::getCols() const {
+    return m_cols;
+}
+
+size_t Heatmap::getMemoryUsage() const {
+    return getCapacityBytes(m_cells) + getCapacityBytes(m_dirtyRows);
+}
@@ -0,0 +1,65 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "glad/glad.h"
+#include "imgui.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+// Visited/frontier/distance overlay kept in a single-channel float texture.
+// Cells are written on the CPU, and each frame only the dirty rows are
+// streamed to the GPU through one of two alternating pixel buffer objects,
+// so the CPU never waits on a transfer that is still in flight.
+// Cell values: 0 unseen, 1 frontier, 2 + distance visited.
+class Heatmap {
+
+public:
+    Heatmap();
+    ~Heatmap();
+
+    void resize(const int rows, const int cols);
+    void clear();
+    void setUnseen(const int x, const int y);
+    void setFrontier(const int x, const int y);
+    void setVisited(const int x, const int y, const int distance);
+    void upload();
+    void draw(ImDrawList *drawList, const ImVec2 gridUpperLeft, const ImVec2 gridBottomRight);
+
+    bool isSupported() const;
+    int getRows() const;
+    int getCols() const;
+    // the CPU side copy; the texture and pixel buffers live on the GPU
+    size_t getMemoryUsage() const;
+
+private:
+    static void renderCallback(const ImDrawList *drawList, const ImDrawCmd *command);
+    void createProgram();
+    void set(const int x, const int y, const float value);
+
+    int m_rows;
+    int m_cols;
+    bool m_supported;
+    float m_maxDistance;
+
+    TrackedVector<float, MEMORY_RENDERING> m_cells;
+    TrackedVector<bool, MEMORY_RENDERING> m_dirtyRows;
+    int m_firstDirtyRow;
+    int m_lastDirtyRow;
+
+    GLuint m_texture;
+    GLuint m_pixelBuffers[2];
+    int m_pixelBufferIndex;
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLuint m_vertexBuffer;
+
+    ImVec2 m_screenUpperLeft;
+    ImVec2 m_screenBottomRight;
+
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <bitset>
+
+#define LOD_BASE_SHIFT 2
+
+LodPyramid::LodPyramid(const Graph &graph): m_rows(0), m_cols(0) {
+    rebuild(graph);
+}
+
+void LodPyramid::rebuild(const Graph &graph) {
+
+    m_rows = graph.getRows();
+    m_cols = graph.getCols();
+    m_levels.clear();
+
+    int shift = LOD_BASE_SHIFT;
+
+    while(true) {
+
+        Level level;
+        level.rows = (m_rows + (1 << shift) - 1) >> shift;
+        level.cols = (m_cols + (1 << shift) - 1) >> shift;
+
+        for(auto channel = 0; channel < CHANNEL_COUNT; channel++) {
+            level.sums[channel].assign((size_t) level.rows * level.cols, 0);
+        }
+
+        m_levels.push_back(std::move(level));
+
+        if(m_levels.back().rows <= 1 && m_levels.back().cols <= 1) break;
+        shift++;
+
+    }
+
+    refresh(graph, 0, 0, m_cols, m_rows);
+
+}
+
+// recomputes the passage sums of every block overlapping [x0, x1) x [y0, y1)
+// straight from the graph's passage words
+void LodPyramid::refresh(const Graph &graph, const int x0, const int y0, const int x1, const int y1) {
+
+    int left = std::max(x0, 0);
+    int top = std::max(y0, 0);
+    int right = std::min(x1, m_cols);
+    int bottom = std::min(y1, m_rows);
+    if(left >= right || top >= bottom) return;
+
+    int shift = getBlockShift(0);
+    int firstBlockCol = left >> shift;
+    int firstBlockRow = top >> shift;
+    int lastBlockCol = (right - 1) >> shift;
+    int lastBlockRow = (bottom - 1) >> shift;
+
+    Level &base = m_levels[0];
+
+    for(auto blockRow = firstBlockRow; blockRow <= lastBlockRow; blockRow++) {
+
+        for(auto blockCol = firstBlockCol; blockCol <= lastBlockCol; blockCol++) {
+
+            int cellLeft = blockCol << shift;
+            int cellRight = std::min(cellLeft + (1 << shift), m_cols);
+            int cellTop = blockRow << shift;
+            int cellBottom = std::min(cellTop + (1 << shift), m_rows);
+
+            // every passage counts once for each of the two cells it connects
+            uint32_t sum = 0;
+
+            for(auto y = cellTop; y < cellBottom; y++) {
+                sum += countPassages(graph, Graph::RIGHT, y, cellLeft, cellRight);
+                sum += countPassages(graph, Graph::RIGHT, y, cellLeft - 1, cellRight - 1);
+                sum += countPassages(graph, Graph::DOWN, y, cellLeft, cellRight);
+                sum += countPassages(graph, Graph::DOWN, y - 1, cellLeft, cellRight);
+            }
+
+            base.sums[PASSAGES][(size_t) blockRow * base.cols + blockCol] = sum;
+
+        }
+
+    }
+
+    // every coarser level is the sum of its four children
+    for(auto level = 1; level < (int) m_levels.size(); level++) {
+
+        Level &parent = m_levels[level];
+        const Level &child = m_levels[level - 1];
+
+        firstBlockCol >>= 1;
+        firstBlockRow >>= 1;
+        lastBlockCol >>= 1;
+        lastBlockRow >>= 1;
+
+        for(auto row = firstBlockRow; row <= lastBlockRow; row++) {
+
+            for(auto col = firstBlockCol; col <= lastBlockCol; col++) {
+
+                uint32_t sum = 0;
+
+                for(auto childRow = row * 2; childRow < std::min(row * 2 + 2, child.rows); childRow++) {
+                    for(auto childCol = col * 2; childCol < std::min(col * 2 + 2, child.cols); childCol++) {
+                        sum += child.sums[PASSAGES][(size_t) childRow * child.cols + childCol];
+                    }
+                }
+
+                parent.sums[PASSAGES][(size_t) row * parent.cols + col] = sum;
+
+            }
+
+        }
+
+    }
+
+}
+
+// number of passages of the given plane owned by cells [x0, x1) of row y
+uint32_t LodPyramid::countPassages(const Graph &graph, const Graph::Passage plane, const int y, const int x0, const int x1) {
+
+    int from = std::max(x0, 0);
+    if(y < 0 || from >= x1) return 0;
+
+    uint32_t count = 0;
+
+    for(auto word = from / 64; word <= (x1 - 1) / 64; word++) {
+
+        uint64_t bits = graph.getPassageWord(plane, y, word);
+        int lower = std::max(from - word * 64, 0);
+        int upper = std::min(x1 - word * 64, 64);
+
+        if(upper < 64) bits &= (1ULL << upper) - 1;
+        bits &= ~((1ULL << lower) - 1);
+
+        count += std::bitset<64>(bits).count();
+
+    }
+
+    return count;
+
+}
+
+void LodPyramid::update(const Graph &graph) {
+    if(graph.getRows() != m_rows || graph.getCols() != m_cols) rebuild(graph);
+}
+
+void LodPyramid::add(const Channel channel, const int x, const int y, const int delta) {
+
+    if(x < 0 || y < 0 || x >= m_cols || y >= m_rows) return;
+
+    for(auto level = 0; level < (int) m_levels.size(); level++) {
+
+        int shift = getBlockShift(level);
+        Level &current = m_levels[level];
+
+        current.sums[channel][(size_t) (y >> shift) * current.cols + (x >> shift)] += delta;
+
+    }
+
+}
+
+void LodPyramid::clear(const Channel channel) {
+    for(Level &level : m_levels) std::fill(level.sums[channel].begin(), level.sums[channel].end(), 0);
+}
+
+// picks the finest level whose texels are at least minTexelSize pixels wide
+int LodPyramid::chooseLevel(const float tileSize, const float minTexelSize) const {
+
+    int level = 0;
+
+    while(level < (int) m_levels.size() - 1 && tileSize * (1 << getBlockShift(level)) < minTexelSize) level++;
+
+    return level;
+
+}
+
+int LodPyramid::getLevelCount() const {
+    return m_levels.size();
+}
+
+int LodPyramid::getLevelRows(const int level) const {
+    return m_levels[level].rows;
+}
+
+int LodPyramid::getLevelCols(const int level) const {
+    return m_levels[level].cols;
+}
+
+int LodPyramid::getBlockShift(const int level) const {
+    return LOD_BASE_SHIFT + level;
+}
+
+// fraction of the block covered by the channel, in [0, 1]
+float LodPyramid::getDensity(const Channel channel, const int level, const int x, const int y) const {
+
+    const Level &current = m_levels[level];
+    int shift = getBlockShift(level);
+
+    // blocks on the right and bottom edge may be only partially covered by the grid
+    int blockCols = std::min(1 << shift, m_cols - (x << shift));
+    int blockRows = std::min(1 << shift, m_rows - (y << shift));
+    float capacity = (float) blockCols * blockRows * (channel == PASSAGES ? 4 : 1);
+
+    return current.sums[channel][(size_t) y * current.cols + x] / capacity;
+
+}
+
+size_t LodPyramid::getMemoryUsage() const {
+
+    size_t bytes = getCapacityBytes(m_levels);
+
+    for(const Level &level : m_levels) {
+        for(auto channel = 0; channel < CHANNEL_COUNT; channel++) bytes += getCapacityBytes(level.sums[channel]);
+    }
+
+    return bytes;
+
+}
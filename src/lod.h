@@ -0,0 +1,58 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "graph.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+// Mipmapped summary of the grid used when tiles get smaller than a few pixels.
+// Level 0 aggregates blocks of (1 << LOD_BASE_SHIFT) x (1 << LOD_BASE_SHIFT)
+// cells and every further level halves the resolution. Each entry stores the
+// sum of its cells, so a single cell change is applied to every level in
+// O(levels) without rescanning the grid.
+class LodPyramid {
+
+public:
+    enum Channel {
+        PASSAGES,
+        VISITED,
+        PATH,
+        CHANNEL_COUNT
+    };
+
+    LodPyramid(const Graph &graph);
+    void rebuild(const Graph &graph);
+    void update(const Graph &graph);
+    void refresh(const Graph &graph, const int x0, const int y0, const int x1, const int y1);
+    void add(const Channel channel, const int x, const int y, const int delta);
+    void clear(const Channel channel);
+
+    int chooseLevel(const float tileSize, const float minTexelSize) const;
+    int getLevelCount() const;
+    int getLevelRows(const int level) const;
+    int getLevelCols(const int level) const;
+    int getBlockShift(const int level) const;
+    float getDensity(const Channel channel, const int level, const int x, const int y) const;
+    size_t getMemoryUsage() const;
+
+private:
+    static uint32_t countPassages(const Graph &graph, const Graph::Passage plane, const int y, const int x0, const int x1);
+
+    struct Level {
+        int rows;
+        int cols;
+        TrackedVector<uint32_t, MEMORY_RENDERING> sums[CHANNEL_COUNT];
+    };
+
+    int m_rows;
+    int m_cols;
+    TrackedVector<Level, MEMORY_RENDERING> m_levels;
+
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "maze.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using std::vector;
+
+// roots store the negated size of their tree, every other cell its parent
+int32_t findRoot(vector<int32_t> *parent, int32_t cell) {
+
+    // path halving keeps the trees flat without recursion
+    while((*parent)[cell] >= 0) {
+        int32_t next = (*parent)[cell];
+        if((*parent)[next] >= 0) (*parent)[cell] = (*parent)[next];
+        cell = next;
+    }
+
+    return cell;
+
+}
+
+// opens the walls in random order, skipping any that would join two already connected cells
+void generateKruskal(Graph *graph, std::mt19937 *random) {
+
+    int rows = graph->getRows();
+    int cols = graph->getCols();
+
+    // a wall is cell * 2 plus 0 for its right and 1 for its lower passage
+    vector<uint32_t> walls;
+    walls.reserve((size_t) rows * cols * 2);
+
+    for(auto y = 0; y < rows; y++) {
+        for(auto x = 0; x < cols; x++) {
+            uint32_t cell = y * cols + x;
+            if(x + 1 < cols) walls.push_back(cell * 2);
+            if(y + 1 < rows) walls.push_back(cell * 2 + 1);
+        }
+    }
+
+    std::shuffle(walls.begin(), walls.end(), *random);
+
+    vector<int32_t> parent = vector<int32_t>((size_t) rows * cols, -1);
+
+    graph->fillRect(0, 0, cols, rows);
+
+    for(uint32_t wall : walls) {
+
+        uint32_t cell = wall / 2;
+        uint32_t other = wall % 2 == 0 ? cell + 1 : cell + cols;
+
+        int32_t a = findRoot(&parent, cell);
+        int32_t b = findRoot(&parent, other);
+        if(a == b) continue;
+
+        // hanging the smaller tree below the larger one keeps the finds short
+        if(parent[a] < parent[b]) std::swap(a, b);
+        parent[b] += parent[a];
+        parent[a] = b;
+        graph->addEdge(Graph::Node(cell % cols, cell / cols, cols), Graph::Node(other % cols, other / cols, cols));
+
+    }
+
+}
+
+// Kruskal over the passages a topology lets every cell own
+template<class Neighborhood>
+void generateKruskal(PassageGrid *grid, const Neighborhood &neighborhood, std::mt19937 *random) {
+
+    size_t cellCount = grid->getCellCount();
+
+    // a wall is cell * 3 plus the owned direction
+    vector<uint32_t> walls;
+    walls.reserve(cellCount * 3);
+
+    for(size_t cell = 0; cell < cellCount; cell++) {
+        int neighbor;
+        for(auto direction = 0; direction < 3; direction++) {
+            if(neighborhood.getNeighbor(cell, direction, &neighbor)) walls.push_back(cell * 3 + direction);
+        }
+    }
+
+    std::shuffle(walls.begin(), walls.end(), *random);
+
+    vector<int32_t> parent = vector<int32_t>(cellCount, -1);
+
+    grid->clear();
+
+    for(uint32_t wall : walls) {
+
+        int cell = wall / 3;
+        int other = cell;
+        neighborhood.getNeighbor(cell, wall % 3, &other);
+
+        int32_t a = findRoot(&parent, cell);
+        int32_t b = findRoot(&parent, other);
+        if(a == b) continue;
+
+        if(parent[a] < parent[b]) std::swap(a, b);
+        parent[b] += parent[a];
+        parent[a] = b;
+        grid->setPassage(cell, wall % 3, true);
+
+    }
+
+}
+
+void generateMaze(Graph *graph, const MazeAlgorithm algorithm, const uint32_t seed) {
+
+    std::mt19937 random = std::mt19937(seed);
+
+    switch(algorithm) {
+        case KRUSKAL:
+            generateKruskal(graph, &random);
+            break;
+    }
+
+}
+
+void generateMaze(PassageGrid *grid, const Topology topology, const MazeAlgorithm algorithm, const uint32_t seed) {
+
+    std::mt19937 random = std::mt19937(seed);
+
+    switch(algorithm) {
+        case KRUSKAL:
+            if(topology == HEX) generateKruskal(grid, HexConnected(*grid), &random);
+            else if(topology == VOXEL) generateKruskal(grid, VoxelConnected(*grid), &random);
+            break;
+    }
+
+}
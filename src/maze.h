@@ -0,0 +1,21 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include "graph.h"
+#include "topology.h"
+
+#include <cstdint>
+
+// Random perfect mazes: every cell ends up reachable from every other cell
+// by exactly one path. The graph keeps its size, all its passages are
+// replaced.
+enum MazeAlgorithm {
+    KRUSKAL
+};
+
+void generateMaze(Graph *graph, const MazeAlgorithm algorithm, const uint32_t seed);
+
+// the same for hex and voxel maps; square topologies use the Graph version
+void generateMaze(PassageGrid *grid, const Topology topology, const MazeAlgorithm algorithm, const uint32_t seed);
+
+#endif
@@ -0,0 +1,355 @@
+#include "mazefile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define MAZE_FILE_BATCH_WORDS (1 << 16)
+#define MAZE_FILE_PAGE_SIZE 4096
+#define MAZE_FILE_MAX_SIDE (1 << 20)
+// node ids are y * cols + x in an int
+#define MAZE_FILE_MAX_CELLS ((uint64_t) INT32_MAX)
+#define MAZE_FILE_MIN_RUN 3
+#define MAZE_FILE_MAX_COUNT 0x7fffffffu
+#define MAZE_FILE_RUN_BIT 0x80000000u
+
+using std::vector;
+
+struct MazeFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t rows;
+    uint32_t cols;
+};
+
+static_assert(sizeof(MazeFileHeader) == 16, "maze file header must stay 16 bytes");
+
+// buffers literal words until a run of MAZE_FILE_MIN_RUN equal words makes a run token worth it
+class RunLengthWriter {
+
+public:
+    RunLengthWriter(std::ofstream &out): m_out(out), m_runWord(0), m_runLength(0) {}
+
+    void push(const uint64_t word) {
+
+        if(m_runLength > 0 && word == m_runWord && m_runLength < MAZE_FILE_MAX_COUNT) {
+            m_runLength++;
+            return;
+        }
+
+        endRun();
+        m_runWord = word;
+        m_runLength = 1;
+
+    }
+
+    void finish() {
+
+        endRun();
+        flushLiterals();
+
+    }
+
+private:
+    void endRun() {
+
+        if(m_runLength >= MAZE_FILE_MIN_RUN) {
+
+            flushLiterals();
+
+            uint32_t token = MAZE_FILE_RUN_BIT | m_runLength;
+            m_out.write((const char*) &token, sizeof(token));
+            m_out.write((const char*) &m_runWord, sizeof(m_runWord));
+
+        } else {
+            m_literals.insert(m_literals.end(), m_runLength, m_runWord);
+            if(m_literals.size() >= MAZE_FILE_BATCH_WORDS) flushLiterals();
+        }
+
+        m_runLength = 0;
+
+    }
+
+    void flushLiterals() {
+
+        if(m_literals.empty()) return;
+
+        uint32_t token = (uint32_t) m_literals.size();
+        m_out.write((const char*) &token, sizeof(token));
+        m_out.write((const char*) m_literals.data(), m_literals.size() * sizeof(uint64_t));
+        m_literals.clear();
+
+    }
+
+    std::ofstream &m_out;
+    vector<uint64_t> m_literals;
+    uint64_t m_runWord;
+    uint32_t m_runLength;
+
+};
+
+class RunLengthReader {
+
+public:
+    RunLengthReader(std::ifstream &in): m_in(in), m_isRun(false), m_runWord(0), m_remaining(0) {}
+
+    bool read(uint64_t *words, size_t count) {
+
+        while(count > 0) {
+
+            if(m_remaining == 0) {
+
+                uint32_t token;
+                if(!m_in.read((char*) &token, sizeof(token))) return false;
+
+                m_isRun = token & MAZE_FILE_RUN_BIT;
+                m_remaining = token & MAZE_FILE_MAX_COUNT;
+                if(m_isRun && !m_in.read((char*) &m_runWord, sizeof(m_runWord))) return false;
+
+            }
+
+            size_t n = std::min(count, (size_t) m_remaining);
+
+            if(m_isRun) std::fill_n(words, n, m_runWord);
+            else if(!m_in.read((char*) words, n * sizeof(uint64_t))) return false;
+
+            words += n;
+            count -= n;
+            m_remaining -= n;
+
+        }
+
+        return true;
+
+    }
+
+private:
+    std::ifstream &m_in;
+    bool m_isRun;
+    uint64_t m_runWord;
+    uint32_t m_remaining;
+
+};
+
+size_t alignToPage(const size_t bytes) {
+    return (bytes + MAZE_FILE_PAGE_SIZE - 1) / MAZE_FILE_PAGE_SIZE * MAZE_FILE_PAGE_SIZE;
+}
+
+// byte size of one plane in a mappable file, padded so the next one starts on a page
+size_t mappedPlaneBytes(const Graph &graph) {
+    return alignToPage((size_t) graph.getRows() * graph.getWordsPerRow() * sizeof(uint64_t));
+}
+
+void writeMappablePlanes(std::ofstream &file, const Graph &graph) {
+
+    vector<char> padding = vector<char>(MAZE_FILE_PAGE_SIZE, 0);
+    size_t planeBytes = (size_t) graph.getRows() * graph.getWordsPerRow() * sizeof(uint64_t);
+
+    file.write(padding.data(), MAZE_FILE_PAGE_SIZE - sizeof(MazeFileHeader));
+
+    // the graph keeps its rows in bands, so the plane is written row by row
+    for(Graph::Passage plane : { Graph::RIGHT, Graph::DOWN }) {
+        for(auto y = 0; y < graph.getRows(); y++) file.write((const char*) graph.getPassageRow(plane, y), graph.getWordsPerRow() * sizeof(uint64_t));
+        file.write(padding.data(), mappedPlaneBytes(graph) - planeBytes);
+    }
+
+}
+
+#ifndef _WIN32
+
+// whether every bit the graph keeps clear is clear: passages out of the grid and the row padding
+bool hasCleanBorders(const uint64_t *right, const uint64_t *down, const int rows, const int cols, const size_t wordsPerRow) {
+
+    for(auto y = 0; y < rows; y++) {
+
+        // right passages end before the last column, down passages before the last row
+        int rightCols = cols - 1;
+        int downCols = y == rows - 1 ? 0 : cols;
+
+        // only the words from the last column on can hold such bits, except in the last row of the down plane
+        for(size_t word = downCols == 0 ? 0 : (cols - 1) / 64; word < wordsPerRow; word++) {
+
+            int first = word * 64;
+            uint64_t rightMask = rightCols >= first + 64 ? 0 : rightCols <= first ? ~0ULL : ~((1ULL << (rightCols - first)) - 1);
+            uint64_t downMask = downCols >= first + 64 ? 0 : downCols <= first ? ~0ULL : ~((1ULL << (downCols - first)) - 1);
+
+            if((right[y * wordsPerRow + word] & rightMask) || (down[y * wordsPerRow + word] & downMask)) return false;
+
+        }
+
+    }
+
+    return true;
+
+}
+
+bool mapPlanes(Graph *graph, const std::string &path, const int rows, const int cols) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    size_t wordsPerRow = (cols + 63) / 64;
+    size_t planeBytes = alignToPage(rows * wordsPerRow * sizeof(uint64_t));
+    size_t length = MAZE_FILE_PAGE_SIZE + 2 * planeBytes;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t) info.st_size < length) {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) return false;
+
+    std::shared_ptr<const void> storage = std::shared_ptr<const void>(mapping, [length](const void *address) { munmap((void*) address, length); });
+    const char *base = (const char*) mapping;
+
+    const uint64_t *right = (const uint64_t*) (base + MAZE_FILE_PAGE_SIZE);
+    const uint64_t *down = (const uint64_t*) (base + MAZE_FILE_PAGE_SIZE + planeBytes);
+
+    // the planes are used as they are, so a file not written by saveMaze could open passages
+    // out of the grid; such files take the copying path, which masks them
+    if(!hasCleanBorders(right, down, rows, cols, wordsPerRow)) return false;
+
+    *graph = Graph(rows, cols, storage, right, down);
+
+    return true;
+
+}
+
+#endif
+
+// copying fallback for mappable files where mapping is not available
+bool readMappablePlanes(std::ifstream &file, Graph *loaded) {
+
+    vector<uint64_t> batch = vector<uint64_t>(std::max(MAZE_FILE_BATCH_WORDS, loaded->getWordsPerRow()));
+    int batchRows = batch.size() / loaded->getWordsPerRow();
+
+    for(Graph::Passage plane : { Graph::RIGHT, Graph::DOWN }) {
+
+        file.seekg(plane == Graph::RIGHT ? MAZE_FILE_PAGE_SIZE : MAZE_FILE_PAGE_SIZE + mappedPlaneBytes(*loaded));
+
+        for(auto y0 = 0; y0 < loaded->getRows(); y0 += batchRows) {
+
+            int count = std::min(batchRows, loaded->getRows() - y0);
+            if(!file.read((char*) batch.data(), (size_t) count * loaded->getWordsPerRow() * sizeof(uint64_t))) return false;
+
+            for(auto row = 0; row < count; row++) loaded->setPassageRow(plane, y0 + row, &batch[(size_t) row * loaded->getWordsPerRow()]);
+
+        }
+
+    }
+
+    return true;
+
+}
+
+bool saveMaze(const Graph &graph, const std::string &path, const uint16_t flags) {
+
+    if(flags & ~(MAZE_FILE_RLE | MAZE_FILE_MAPPABLE) || flags == (MAZE_FILE_RLE | MAZE_FILE_MAPPABLE)) return false;
+
+    std::ofstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    bool compress = flags & MAZE_FILE_RLE;
+
+    MazeFileHeader header;
+    std::memcpy(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic));
+    header.version = MAZE_FILE_VERSION;
+    header.flags = flags;
+    header.rows = graph.getRows();
+    header.cols = graph.getCols();
+    file.write((const char*) &header, sizeof(header));
+
+    if(flags & MAZE_FILE_MAPPABLE) {
+        writeMappablePlanes(file, graph);
+        return (bool) file;
+    }
+
+    int wordsPerRow = graph.getWordsPerRow();
+    RunLengthWriter writer = RunLengthWriter(file);
+
+    for(auto y = 0; y < graph.getRows(); y++) {
+
+        for(Graph::Passage plane : { Graph::RIGHT, Graph::DOWN }) {
+
+            const uint64_t *row = graph.getPassageRow(plane, y);
+
+            if(compress) for(auto word = 0; word < wordsPerRow; word++) writer.push(row[word]);
+            else file.write((const char*) row, wordsPerRow * sizeof(uint64_t));
+
+        }
+
+    }
+
+    if(compress) writer.finish();
+
+    return (bool) file;
+
+}
+
+bool loadMaze(Graph *graph, const std::string &path) {
+
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    MazeFileHeader header;
+    if(!file.read((char*) &header, sizeof(header))) return false;
+
+    if(std::memcmp(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic)) != 0) return false;
+    if(header.version != MAZE_FILE_VERSION) return false;
+    if(header.flags != 0 && header.flags != MAZE_FILE_RLE && header.flags != MAZE_FILE_MAPPABLE) return false;
+    if(header.rows == 0 || header.cols == 0 || header.rows > MAZE_FILE_MAX_SIDE || header.cols > MAZE_FILE_MAX_SIDE) return false;
+    if((uint64_t) header.rows * header.cols > MAZE_FILE_MAX_CELLS) return false;
+
+#ifndef _WIN32
+    if(header.flags & MAZE_FILE_MAPPABLE && mapPlanes(graph, path, header.rows, header.cols)) return true;
+#endif
+
+    Graph loaded = Graph(header.rows, header.cols);
+
+    if(header.flags & MAZE_FILE_MAPPABLE) {
+        if(!readMappablePlanes(file, &loaded)) return false;
+        *graph = std::move(loaded);
+        return true;
+    }
+
+    // a batch holds both planes of as many rows as fit into MAZE_FILE_BATCH_WORDS
+    size_t rowWords = 2 * (size_t) loaded.getWordsPerRow();
+    int batchRows = std::max(1, (int) (MAZE_FILE_BATCH_WORDS / rowWords));
+    vector<uint64_t> batch = vector<uint64_t>(batchRows * rowWords);
+    RunLengthReader reader = RunLengthReader(file);
+
+    for(auto y0 = 0; y0 < loaded.getRows(); y0 += batchRows) {
+
+        int count = std::min(batchRows, loaded.getRows() - y0);
+        size_t words = count * rowWords;
+
+        if(header.flags & MAZE_FILE_RLE) {
+            if(!reader.read(batch.data(), words)) return false;
+        } else if(!file.read((char*) batch.data(), words * sizeof(uint64_t))) {
+            return false;
+        }
+
+        for(auto row = 0; row < count; row++) {
+            loaded.setPassageRow(Graph::RIGHT, y0 + row, &batch[row * rowWords]);
+            loaded.setPassageRow(Graph::DOWN, y0 + row, &batch[row * rowWords + rowWords / 2]);
+        }
+
+    }
+
+    *graph = std::move(loaded);
+
+    return true;
+
+}
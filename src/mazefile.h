@@ -0,0 +1,39 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include "graph.h"
+
+#include <string>
+
+#define MAZE_FILE_MAGIC "PFVM"
+#define MAZE_FILE_VERSION 1
+
+// Binary maze files. A 16 byte header (magic, version, flags, rows, cols)
+// is followed by the passage bitplanes row by row: the right plane's words
+// of a row, then its down plane's words, i.e. 2 bits per cell padded to
+// whole 64 bit words. Words are stored little-endian as in memory.
+//
+// With MAZE_FILE_RLE the same word stream is run-length coded: a 32 bit
+// token whose high bit marks a run (one word repeated count times) or a
+// literal block (count words copied verbatim), count in the low 31 bits.
+//
+// With MAZE_FILE_MAPPABLE the planes are stored whole instead, each one
+// starting on a page boundary, so the file can be mapped read-only and the
+// Graph used in place: opening costs the same for any map size and every
+// process opening the file shares the same physical pages.
+//
+// Both streaming paths go through a fixed batch of rows, so no per-node
+// objects or whole-file buffers are built.
+enum MazeFileFlags : uint16_t {
+    MAZE_FILE_RLE = 1,
+    MAZE_FILE_MAPPABLE = 2
+};
+
+// flags is 0, MAZE_FILE_RLE or MAZE_FILE_MAPPABLE
+bool saveMaze(const Graph &graph, const std::string &path, const uint16_t flags);
+
+// replaces the graph only if the whole file could be read; mappable files
+// are mapped instead of read where the platform supports it
+bool loadMaze(Graph *graph, const std::string &path);
+
+#endif
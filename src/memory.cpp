@@ -0,0 +1,121 @@
+#include "memory.h"
+
+#include <atomic>
+
+namespace {
+
+struct Counters {
+    std::atomic<size_t> current;
+    std::atomic<size_t> peak;
+    std::atomic<size_t> allocations;
+};
+
+Counters counters[MEMORY_SUBSYSTEM_COUNT];
+Counters total;
+
+void raisePeak(std::atomic<size_t> *peak, const size_t value) {
+
+    size_t seen = peak->load(std::memory_order_relaxed);
+    while(seen < value && !peak->compare_exchange_weak(seen, value, std::memory_order_relaxed));
+
+}
+
+class TrackingResource : public std::pmr::memory_resource {
+
+public:
+    TrackingResource(const MemorySubsystem subsystem): m_subsystem(subsystem) {}
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+
+        void *pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        recordAllocation(m_subsystem, bytes);
+
+        return pointer;
+
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+
+        recordDeallocation(m_subsystem, bytes);
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    MemorySubsystem m_subsystem;
+
+};
+
+}
+
+const char *getMemorySubsystemName(const MemorySubsystem subsystem) {
+
+    switch(subsystem) {
+        case MEMORY_GRAPH:
+            return "graph";
+        case MEMORY_SEARCH:
+            return "search";
+        case MEMORY_FLOW_FIELD:
+            return "flow_field";
+        case MEMORY_RENDERING:
+            return "rendering";
+        case MEMORY_EDITS:
+            return "edits";
+        case MEMORY_TRACE:
+            return "trace";
+        default:
+            return "unknown";
+    }
+
+}
+
+void recordAllocation(const MemorySubsystem subsystem, const size_t bytes) {
+
+    Counters &counter = counters[subsystem];
+
+    raisePeak(&counter.peak, counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+
+    raisePeak(&total.peak, total.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    total.allocations.fetch_add(1, std::memory_order_relaxed);
+
+}
+
+void recordDeallocation(const MemorySubsystem subsystem, const size_t bytes) {
+
+    counters[subsystem].current.fetch_sub(bytes, std::memory_order_relaxed);
+    total.current.fetch_sub(bytes, std::memory_order_relaxed);
+
+}
+
+MemoryStats getMemoryStats(const MemorySubsystem subsystem) {
+
+    const Counters &counter = counters[subsystem];
+
+    return MemoryStats { counter.current.load(std::memory_order_relaxed), counter.peak.load(std::memory_order_relaxed), counter.allocations.load(std::memory_order_relaxed) };
+
+}
+
+MemoryStats getTotalMemoryStats() {
+    return MemoryStats { total.current.load(std::memory_order_relaxed), total.peak.load(std::memory_order_relaxed), total.allocations.load(std::memory_order_relaxed) };
+}
+
+// the resources live as long as the program, so containers freed during static destruction can still use them
+std::pmr::memory_resource *getTrackingResource(const MemorySubsystem subsystem) {
+
+    static TrackingResource *resources[MEMORY_SUBSYSTEM_COUNT] = {
+        new TrackingResource(MEMORY_GRAPH),
+        new TrackingResource(MEMORY_SEARCH),
+        new TrackingResource(MEMORY_FLOW_FIELD),
+        new TrackingResource(MEMORY_RENDERING),
+        new TrackingResource(MEMORY_EDITS),
+        new TrackingResource(MEMORY_TRACE)
+    };
+
+    return resources[subsystem];
+
+}
@@ -0,0 +1,93 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Parts of the program whose heap use is counted separately. Their large
+// containers allocate through TrackingAllocator or a tracking memory
+// resource, which keep live bytes, peak bytes and allocation counts per
+// subsystem. Counters are process wide and safe to update from any thread.
+enum MemorySubsystem {
+    MEMORY_GRAPH,
+    MEMORY_SEARCH,
+    MEMORY_FLOW_FIELD,
+    MEMORY_RENDERING,
+    MEMORY_EDITS,
+    MEMORY_TRACE,
+    MEMORY_SUBSYSTEM_COUNT
+};
+
+struct MemoryStats {
+    size_t currentBytes;
+    size_t peakBytes;
+    size_t allocations;
+};
+
+// lower case identifier used on command lines and in reports
+const char *getMemorySubsystemName(const MemorySubsystem subsystem);
+
+void recordAllocation(const MemorySubsystem subsystem, const size_t bytes);
+void recordDeallocation(const MemorySubsystem subsystem, const size_t bytes);
+
+MemoryStats getMemoryStats(const MemorySubsystem subsystem);
+// all subsystems together; the peak is the highest total, not the sum of the peaks
+MemoryStats getTotalMemoryStats();
+
+// counts into a subsystem on top of new and delete, for pmr containers
+std::pmr::memory_resource *getTrackingResource(const MemorySubsystem subsystem);
+
+template<class T, MemorySubsystem SUBSYSTEM>
+class TrackingAllocator {
+
+public:
+    typedef T value_type;
+
+    template<class U>
+    struct rebind {
+        typedef TrackingAllocator<U, SUBSYSTEM> other;
+    };
+
+    TrackingAllocator() = default;
+
+    template<class U>
+    TrackingAllocator(const TrackingAllocator<U, SUBSYSTEM>&) {}
+
+    T *allocate(const size_t count) {
+
+        recordAllocation(SUBSYSTEM, count * sizeof(T));
+
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+
+    }
+
+    void deallocate(T *pointer, const size_t count) {
+
+        recordDeallocation(SUBSYSTEM, count * sizeof(T));
+        ::operator delete(pointer);
+
+    }
+
+    friend bool operator==(const TrackingAllocator&, const TrackingAllocator&) { return true; }
+    friend bool operator!=(const TrackingAllocator&, const TrackingAllocator&) { return false; }
+
+};
+
+template<class T, MemorySubsystem SUBSYSTEM>
+using TrackedVector = std::vector<T, TrackingAllocator<T, SUBSYSTEM>>;
+
+// heap bytes a vector holds, used or not
+template<class T, class Allocator>
+size_t getCapacityBytes(const std::vector<T, Allocator> &values) {
+    return values.capacity() * sizeof(T);
+}
+
+// packed one bit per value
+template<class Allocator>
+size_t getCapacityBytes(const std::vector<bool, Allocator> &values) {
+    return (values.capacity() + 7) / 8;
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "movingai.h"
+#include "arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#define TERRAIN_BLOCKED 0
+#define TERRAIN_GROUND 1
+#define TERRAIN_WATER 2
+
+int terrainOf(const char tile) {
+
+    switch(tile) {
+        case '.':
+        case 'G':
+        case 'S':
+            return TERRAIN_GROUND;
+        case 'W':
+            return TERRAIN_WATER;
+        default:
+            return TERRAIN_BLOCKED;
+    }
+
+}
+
+bool terrainConnects(const char a, const char b) {
+
+    int terrain = terrainOf(a);
+
+    return terrain != TERRAIN_BLOCKED && terrain == terrainOf(b);
+
+}
+
+// the passage words of one map row; down is only built when the next row is known
+void buildRowWords(const std::string &row, const std::string *below, const int cols, vector<uint64_t> *right, vector<uint64_t> *down) {
+
+    std::fill(right->begin(), right->end(), 0);
+    std::fill(down->begin(), down->end(), 0);
+
+    for(auto x = 0; x < cols; x++) {
+        if(x + 1 < cols && terrainConnects(row[x], row[x + 1])) (*right)[x / 64] |= 1ULL << (x % 64);
+        if(below && terrainConnects(row[x], (*below)[x])) (*down)[x / 64] |= 1ULL << (x % 64);
+    }
+
+}
+
+bool loadMovingAiMap(Graph *graph, const std::string &path) {
+
+    std::ifstream file(path);
+    if(!file) return false;
+
+    int rows = -1;
+    int cols = -1;
+    std::string line;
+
+    while(std::getline(file, line)) {
+
+        std::istringstream header(line);
+        std::string key;
+        header >> key;
+
+        if(key == "height") header >> rows;
+        else if(key == "width") header >> cols;
+        else if(key == "map") break;
+
+    }
+
+    // node ids are y * cols + x in an int
+    if(rows <= 0 || cols <= 0 || (int64_t) rows * cols > INT32_MAX) return false;
+
+    Graph loaded = Graph(rows, cols);
+    vector<uint64_t> right = vector<uint64_t>(loaded.getWordsPerRow());
+    vector<uint64_t> down = vector<uint64_t>(loaded.getWordsPerRow());
+    std::string previous;
+    std::string current;
+
+    // a row's down passages need the row below, so each row is written one line late
+    for(auto y = 0; y < rows; y++) {
+
+        if(!std::getline(file, current)) return false;
+        if(!current.empty() && current.back() == '\r') current.pop_back();
+        if((int) current.size() < cols) return false;
+
+        if(y > 0) {
+            buildRowWords(previous, &current, cols, &right, &down);
+            loaded.setPassageRow(Graph::RIGHT, y - 1, right.data());
+            loaded.setPassageRow(Graph::DOWN, y - 1, down.data());
+        }
+
+        std::swap(previous, current);
+
+    }
+
+    buildRowWords(previous, nullptr, cols, &right, &down);
+    loaded.setPassageRow(Graph::RIGHT, rows - 1, right.data());
+    loaded.setPassageRow(Graph::DOWN, rows - 1, down.data());
+
+    *graph = std::move(loaded);
+
+    return true;
+
+}
+
+bool loadMovingAiScenarios(const std::string &path, const int cols, vector<Scenario> *scenarios) {
+
+    std::ifstream file(path);
+    if(!file) return false;
+
+    std::string line;
+    if(!std::getline(file, line) || line.rfind("version", 0) != 0) return false;
+
+    vector<Scenario> loaded;
+
+    while(std::getline(file, line)) {
+
+        std::istringstream fields(line);
+        Scenario scenario = Scenario { 0, "", 0, 0, Graph::Node(0, 0, cols), Graph::Node(0, 0, cols), 0.0 };
+        int startX, startY, goalX, goalY;
+
+        if(!(fields >> scenario.bucket >> scenario.map >> scenario.mapWidth >> scenario.mapHeight >> startX >> startY >> goalX >> goalY >> scenario.optimalLength)) continue;
+
+        scenario.start = Graph::Node(startX, startY, cols);
+        scenario.goal = Graph::Node(goalX, goalY, cols);
+        loaded.push_back(scenario);
+
+    }
+
+    *scenarios = std::move(loaded);
+
+    return true;
+
+}
+
+void runScenarios(const Graph &graph, const Search::Algorithm algorithm, const Topology topology, const vector<Scenario> &scenarios, vector<ScenarioResult> *results) {
+
+    results->clear();
+    results->reserve(scenarios.size());
+
+    if(graph.getRows() == 0 || graph.getCols() == 0) {
+        results->assign(scenarios.size(), ScenarioResult { false, 0.0, 0, -1, 0.0 });
+        return;
+    }
+
+    SearchArena &arena = SearchArena::forThread();
+    arena.reset();
+
+    {
+
+        // one search restarted per scenario, so a query only pays for the cells it reaches
+        Search search = Search(graph, algorithm, Graph::Node(0, 0, graph.getCols()), Graph::Node(0, 0, graph.getCols()), topology, arena.getResource());
+
+        for(const Scenario &scenario : scenarios) {
+
+            ScenarioResult result = ScenarioResult { false, 0.0, 0, -1, 0.0 };
+
+            bool inside = scenario.start.x >= 0 && scenario.start.x < graph.getCols() && scenario.start.y >= 0 && scenario.start.y < graph.getRows()
+                && scenario.goal.x >= 0 && scenario.goal.x < graph.getCols() && scenario.goal.y >= 0 && scenario.goal.y < graph.getRows();
+
+            if(inside) {
+
+                auto begin = std::chrono::steady_clock::now();
+
+                search.restart(scenario.start, scenario.goal);
+                while(!search.step(INT32_MAX, nullptr, nullptr));
+
+                auto end = std::chrono::steady_clock::now();
+
+                result.solved = search.hasPath();
+                result.latencyMs = std::chrono::duration<double, std::milli>(end - begin).count();
+                result.expansions = search.getExpansions();
+                result.pathLength = search.getPathLength();
+                if(result.solved && scenario.optimalLength > 0) result.gap = search.getPathCost() / scenario.optimalLength - 1.0;
+
+            }
+
+            results->push_back(result);
+
+        }
+
+    }
+
+    arena.reset();
+
+}
+
+bool dumpScenarioCsv(const vector<Scenario> &scenarios, const vector<ScenarioResult> &results, const std::string &path) {
+
+    std::ofstream file(path);
+    if(!file) return false;
+
+    file << "bucket,start_x,start_y,goal_x,goal_y,reference,solved,latency_ms,expansions,path_length,gap\n";
+
+    for(size_t i = 0; i < scenarios.size() && i < results.size(); i++) {
+
+        const Scenario &scenario = scenarios[i];
+        const ScenarioResult &result = results[i];
+
+        file << scenario.bucket << ',' << scenario.start.x << ',' << scenario.start.y << ',' << scenario.goal.x << ',' << scenario.goal.y << ','
+             << scenario.optimalLength << ',' << result.solved << ',' << result.latencyMs << ',' << result.expansions << ','
+             << result.pathLength << ',' << result.gap << '\n';
+
+    }
+
+    return (bool) file;
+
+}
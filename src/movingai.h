@@ -0,0 +1,49 @@
+#ifndef MOVINGAI_H
+#define MOVINGAI_H
+
+#include "graph.h"
+#include "search.h"
+
+#include <string>
+#include <vector>
+
+using std::vector;
+
+// Importer and runner for the Moving AI grid benchmarks
+// (https://movingai.com/benchmarks/). Passable terrain becomes connected
+// cells of a Graph. Searched 4-connected, the octile reference lengths of
+// the scenario files are lower bounds rather than exact optima;
+// EIGHT_CONNECTED_NO_CORNER_CUTTING follows the benchmark's own movement
+// rules, with diagonals costing 1.4 instead of sqrt(2).
+struct Scenario {
+    int bucket;
+    std::string map;
+    int mapWidth;
+    int mapHeight;
+    Graph::Node start;
+    Graph::Node goal;
+    double optimalLength;
+};
+
+struct ScenarioResult {
+    bool solved;
+    double latencyMs;
+    int expansions;
+    int pathLength;
+
+    // path cost / optimalLength - 1
+    double gap;
+};
+
+// '.', 'G' and 'S' connect to each other, water 'W' only connects to water,
+// everything else ('@', 'O', 'T') stays walled off
+bool loadMovingAiMap(Graph *graph, const std::string &path);
+
+bool loadMovingAiScenarios(const std::string &path, const int cols, vector<Scenario> *scenarios);
+
+// runs every scenario to completion, results line up with scenarios
+void runScenarios(const Graph &graph, const Search::Algorithm algorithm, const Topology topology, const vector<Scenario> &scenarios, vector<ScenarioResult> *results);
+
+bool dumpScenarioCsv(const vector<Scenario> &scenarios, const vector<ScenarioResult> &results, const std::string &path);
+
+#endif
@@ -0,0 +1,56 @@
+#include "pacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+// wake up occasionally even without input so the window never looks hung
+#define IDLE_TIMEOUT 0.5
+// ImGui needs a few frames after an input event to settle hover and active states
+#define SETTLE_FRAMES 3
+
+FramePacer::FramePacer(const int targetFps): m_targetFps(targetFps), m_pendingFrames(SETTLE_FRAMES), m_idle(false), m_lastFrameTime(0.0) {}
+
+void FramePacer::waitForNextFrame(const bool animating) {
+
+    m_idle = false;
+
+    if(animating) {
+
+        double deadline = m_lastFrameTime + 1.0 / m_targetFps;
+
+        // keep handling events while waiting for the frame deadline
+        for(double now = glfwGetTime(); now < deadline; now = glfwGetTime()) glfwWaitEventsTimeout(deadline - now);
+        glfwPollEvents();
+
+    } else if(m_pendingFrames > 0) {
+
+        glfwPollEvents();
+        m_pendingFrames--;
+
+    } else {
+
+        double waitStart = glfwGetTime();
+        glfwWaitEventsTimeout(IDLE_TIMEOUT);
+
+        // an early wake-up means an event arrived, a full timeout only needs a single frame
+        if(glfwGetTime() - waitStart < IDLE_TIMEOUT) m_pendingFrames = SETTLE_FRAMES - 1;
+        m_idle = true;
+
+    }
+
+    m_lastFrameTime = glfwGetTime();
+
+}
+
+bool FramePacer::isIdle() const {
+    return m_idle;
+}
+
+int FramePacer::getTargetFps() const {
+    return m_targetFps;
+}
+
+void FramePacer::setTargetFps(const int targetFps) {
+    m_targetFps = std::max(targetFps, 1);
+}
@@ -0,0 +1,26 @@
+#ifndef PACER_H
+#define PACER_H
+
+// Decides how the main loop waits for the next frame. While something is
+// animating, frames are paced to the target rate; otherwise the loop sleeps
+// in glfwWaitEventsTimeout until input arrives.
+class FramePacer {
+
+public:
+    FramePacer(const int targetFps);
+
+    void waitForNextFrame(const bool animating);
+
+    bool isIdle() const;
+    int getTargetFps() const;
+    void setTargetFps(const int targetFps);
+
+private:
+    int m_targetFps;
+    int m_pendingFrames;
+    bool m_idle;
+    double m_lastFrameTime;
+
+};
+
+#endif
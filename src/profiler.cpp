@@ -0,0 +1,129 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+float percentileOf(std::vector<float> &values, const float percentile) {
+
+    auto nth = values.begin() + (size_t) (percentile * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+
+    return *nth;
+
+}
+
+Profiler::Profiler(): m_samples(), m_frameCount(0), m_current(), m_currentPhase(PHASE_COUNT) {}
+
+void Profiler::beginFrame() {
+
+    m_current = FrameSample();
+    m_current.frame = m_frameCount.load(std::memory_order_relaxed);
+    m_currentPhase = PHASE_COUNT;
+    m_frameStart = std::chrono::steady_clock::now();
+    m_phaseStart = m_frameStart;
+
+}
+
+// phases may be entered several times per frame; their times accumulate
+void Profiler::beginPhase(const Phase phase) {
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if(m_currentPhase != PHASE_COUNT) {
+        std::chrono::duration<float, std::milli> elapsed = now - m_phaseStart;
+        m_current.phaseMs[m_currentPhase] += elapsed.count();
+    }
+
+    m_currentPhase = phase;
+    m_phaseStart = now;
+
+}
+
+void Profiler::endFrame() {
+
+    beginPhase(PHASE_COUNT);
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_frameStart;
+    m_current.totalMs = elapsed.count();
+
+    uint64_t frame = m_frameCount.load(std::memory_order_relaxed);
+    m_samples[frame % PROFILER_CAPACITY] = m_current;
+
+    // publish the sample only after it has been fully written
+    m_frameCount.store(frame + 1, std::memory_order_release);
+
+}
+
+const char *Profiler::getPhaseName(const Phase phase) {
+
+    switch(phase) {
+        case EVENTS: return "Events";
+        case CONTROLS: return "Controls";
+        case GRID: return "Grid";
+        case INPUT: return "Input";
+        case SEARCH: return "Search";
+        case RENDER: return "Render";
+        case SWAP: return "Submit/Swap";
+        default: return "Unknown";
+    }
+
+}
+
+// oldest sample first
+std::vector<Profiler::FrameSample> Profiler::getSamples() const {
+
+    uint64_t frameCount = m_frameCount.load(std::memory_order_acquire);
+    uint64_t first = frameCount > PROFILER_CAPACITY ? frameCount - PROFILER_CAPACITY : 0;
+
+    std::vector<FrameSample> samples;
+    samples.reserve(frameCount - first);
+
+    for(auto frame = first; frame < frameCount; frame++) samples.push_back(m_samples[frame % PROFILER_CAPACITY]);
+
+    return samples;
+
+}
+
+std::array<Profiler::Percentiles, Profiler::PHASE_COUNT + 1> Profiler::summarize() const {
+
+    std::array<Percentiles, PHASE_COUNT + 1> summary = {};
+
+    std::vector<FrameSample> samples = getSamples();
+    if(samples.empty()) return summary;
+
+    std::vector<float> values(samples.size());
+
+    for(auto phase = 0; phase <= PHASE_COUNT; phase++) {
+
+        for(size_t i = 0; i < samples.size(); i++) values[i] = phase == PHASE_COUNT ? samples[i].totalMs : samples[i].phaseMs[phase];
+
+        summary[phase].p50 = percentileOf(values, 0.50f);
+        summary[phase].p95 = percentileOf(values, 0.95f);
+        summary[phase].p99 = percentileOf(values, 0.99f);
+
+    }
+
+    return summary;
+
+}
+
+bool Profiler::dumpCsv(const std::string &path) const {
+
+    std::ofstream file(path);
+    if(!file) return false;
+
+    file << "frame";
+    for(auto phase = 0; phase < PHASE_COUNT; phase++) file << "," << getPhaseName((Phase) phase);
+    file << ",Total\n";
+
+    for(const FrameSample &sample : getSamples()) {
+
+        file << sample.frame;
+        for(auto phase = 0; phase < PHASE_COUNT; phase++) file << "," << sample.phaseMs[phase];
+        file << "," << sample.totalMs << "\n";
+
+    }
+
+    return (bool) file;
+
+}
@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PROFILER_CAPACITY 512
+
+// Per-phase frame timings kept in a single-producer ring buffer. The main
+// loop marks the start of each phase; the time until the next mark is
+// attributed to it. The main loop is the only writer, readers (the overlay,
+// CSV export) copy samples out by index without taking a lock.
+class Profiler {
+
+public:
+    enum Phase {
+        EVENTS,
+        CONTROLS,
+        GRID,
+        INPUT,
+        SEARCH,
+        RENDER,
+        SWAP,
+        PHASE_COUNT
+    };
+
+    struct FrameSample {
+        uint64_t frame;
+        float phaseMs[PHASE_COUNT];
+        float totalMs;
+    };
+
+    struct Percentiles {
+        float p50;
+        float p95;
+        float p99;
+    };
+
+    Profiler();
+    void beginFrame();
+    void beginPhase(const Phase phase);
+    void endFrame();
+
+    static const char *getPhaseName(const Phase phase);
+    std::vector<FrameSample> getSamples() const;
+    // one entry per phase, the frame total is stored at index PHASE_COUNT
+    std::array<Percentiles, PHASE_COUNT + 1> summarize() const;
+    bool dumpCsv(const std::string &path) const;
+
+private:
+    std::array<FrameSample, PROFILER_CAPACITY> m_samples;
+    std::atomic<uint64_t> m_frameCount;
+    FrameSample m_current;
+    int m_currentPhase;
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::chrono::steady_clock::time_point m_phaseStart;
+
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "race.h"
+
+#include <chrono>
+
+AlgorithmRace::AlgorithmRace(): m_collectVisited(false), m_stop(false), m_waiting(0), m_running(0) {}
+
+AlgorithmRace::~AlgorithmRace() {
+    stop();
+}
+
+void AlgorithmRace::start(const std::shared_ptr<const Graph> &snapshot, const vector<Search::Algorithm> &algorithms, const Graph::Node start, const Graph::Node target, const Topology topology, const bool collectVisited) {
+
+    stop();
+
+    m_snapshot = snapshot;
+    m_collectVisited = collectVisited;
+    m_stop = false;
+    m_waiting = algorithms.size();
+    m_running = algorithms.size();
+    m_lanes.clear();
+
+    for(Search::Algorithm algorithm : algorithms) {
+        m_lanes.push_back(std::make_unique<Lane>());
+        m_lanes.back()->status = RaceStatus { algorithm, false, false, 0, 0.0, 0, -1.0, -1 };
+    }
+
+    for(auto &lane : m_lanes) lane->thread = std::thread(&AlgorithmRace::run, this, lane.get(), start, target, topology);
+
+}
+
+void AlgorithmRace::stop() {
+
+    m_stop = true;
+    wait();
+
+}
+
+void AlgorithmRace::wait() {
+
+    for(auto &lane : m_lanes) {
+        if(lane->thread.joinable()) lane->thread.join();
+    }
+
+}
+
+bool AlgorithmRace::isRunning() const {
+    return m_running > 0;
+}
+
+size_t AlgorithmRace::getLaneCount() const {
+    return m_lanes.size();
+}
+
+RaceStatus AlgorithmRace::getStatus(const size_t lane) const {
+
+    std::lock_guard<std::mutex> lock(m_lanes[lane]->mutex);
+
+    return m_lanes[lane]->status;
+
+}
+
+void AlgorithmRace::takeVisited(const size_t lane, vector<Graph::Node> *visited) {
+
+    std::lock_guard<std::mutex> lock(m_lanes[lane]->mutex);
+
+    visited->insert(visited->end(), m_lanes[lane]->visited.begin(), m_lanes[lane]->visited.end());
+    m_lanes[lane]->visited.clear();
+
+}
+
+void AlgorithmRace::getPath(const size_t lane, vector<Graph::Node> *path) const {
+
+    std::lock_guard<std::mutex> lock(m_lanes[lane]->mutex);
+
+    *path = m_lanes[lane]->path;
+
+}
+
+const std::shared_ptr<const Graph> &AlgorithmRace::getSnapshot() const {
+    return m_snapshot;
+}
+
+void AlgorithmRace::run(Lane *lane, const Graph::Node start, const Graph::Node target, const Topology topology) {
+
+    Search::Algorithm algorithm = lane->status.algorithm;
+
+    // nobody starts before every lane is ready, so thread start-up is not part of the race
+    m_waiting--;
+    while(m_waiting > 0 && !m_stop) std::this_thread::yield();
+
+    auto begin = std::chrono::steady_clock::now();
+
+    Search search = Search(*m_snapshot, algorithm, start, target, topology);
+    vector<Graph::Node> visited;
+    size_t peakBytes = 0;
+    bool finished = false;
+
+    while(!finished && !m_stop) {
+
+        visited.clear();
+        finished = search.step(RACE_BATCH_EXPANSIONS, nullptr, m_collectVisited ? &visited : nullptr);
+
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        peakBytes = std::max(peakBytes, search.getMemoryUsage());
+
+        std::lock_guard<std::mutex> lock(lane->mutex);
+
+        lane->status.expansions = search.getExpansions();
+        lane->status.wallMs = wallMs;
+        lane->status.peakBytes = peakBytes;
+        lane->visited.insert(lane->visited.end(), visited.begin(), visited.end());
+
+        if(finished) {
+            lane->status.finished = true;
+            lane->status.found = search.hasPath();
+            lane->status.pathCost = search.getPathCost();
+            lane->status.pathLength = search.getPathLength();
+            search.getPath(&lane->path);
+        }
+
+    }
+
+    m_running--;
+
+}
@@ -0,0 +1,83 @@
+#ifndef RACE_H
+#define RACE_H
+
+#include "graph.h"
+#include "search.h"
+#include "topology.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+// expansions a lane runs between two status updates
+#define RACE_BATCH_EXPANSIONS 1024
+
+// One lane's progress as last published by its thread.
+struct RaceStatus {
+    Search::Algorithm algorithm;
+    bool finished;
+    bool found;
+    int expansions;
+    double wallMs;
+    // largest footprint the search reported between batches
+    size_t peakBytes;
+    double pathCost;
+    int pathLength;
+};
+
+// Runs several algorithms at once, one thread per lane, against a shared
+// read-only snapshot of a graph, so edits made meanwhile cannot reach the
+// race. The lanes start together once every thread is up; each steps its
+// search in batches and publishes status (and, if asked, newly visited
+// cells) under its own lock, so reading them never stalls the other lanes.
+class AlgorithmRace {
+
+public:
+    AlgorithmRace();
+    ~AlgorithmRace();
+
+    AlgorithmRace(const AlgorithmRace&) = delete;
+    AlgorithmRace &operator=(const AlgorithmRace&) = delete;
+
+    // stops a race still running before starting the new one
+    void start(const std::shared_ptr<const Graph> &snapshot, const vector<Search::Algorithm> &algorithms, const Graph::Node start, const Graph::Node target, const Topology topology, const bool collectVisited);
+    // asks the lanes to give up and waits for their threads
+    void stop();
+    // waits until every lane has finished
+    void wait();
+
+    bool isRunning() const;
+    size_t getLaneCount() const;
+    RaceStatus getStatus(const size_t lane) const;
+    // moves the cells a lane visited since the last call into visited
+    void takeVisited(const size_t lane, vector<Graph::Node> *visited);
+    // empty until the lane found its path
+    void getPath(const size_t lane, vector<Graph::Node> *path) const;
+    const std::shared_ptr<const Graph> &getSnapshot() const;
+
+private:
+    struct Lane {
+        std::thread thread;
+        mutable std::mutex mutex;
+        RaceStatus status;
+        vector<Graph::Node> visited;
+        vector<Graph::Node> path;
+    };
+
+    void run(Lane *lane, const Graph::Node start, const Graph::Node target, const Topology topology);
+
+    std::shared_ptr<const Graph> m_snapshot;
+    vector<std::unique_ptr<Lane>> m_lanes;
+    bool m_collectVisited;
+    std::atomic<bool> m_stop;
+    std::atomic<int> m_waiting;
+    std::atomic<int> m_running;
+
+};
+
+#endif
@@ -0,0 +1,519 @@
+#include "search.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+#define MORTON_TILE_BITS 4
+#define MORTON_TILE_SIZE (1 << MORTON_TILE_BITS)
+
+class RowMajorLayout {
+
+public:
+    size_t getIndex(const int id) const {
+        return id;
+    }
+
+};
+
+// Tiles of MORTON_TILE_SIZE squared cells stored row by row, the cells of
+// a tile in Z order. Rows and columns are padded to whole tiles. Every
+// neighbour needs its coordinates back from the id, so the division by the
+// column count is a multiplication by a rounded up reciprocal, exact for
+// any non-negative int (Granlund and Montgomery).
+class MortonTileLayout {
+
+public:
+    MortonTileLayout(const int cols): m_cols(cols), m_tilesPerRow((cols + MORTON_TILE_SIZE - 1) / MORTON_TILE_SIZE), m_shift(32) {
+
+        while((1ull << (m_shift - 32)) < (uint64_t) cols) m_shift++;
+        m_reciprocal = ((1ull << m_shift) + cols - 1) / cols;
+
+    }
+
+    size_t getIndex(const int id) const {
+
+        int y = (int) ((uint64_t) id * m_reciprocal >> m_shift);
+        int x = id - y * m_cols;
+        size_t tile = (size_t) (y >> MORTON_TILE_BITS) * m_tilesPerRow + (x >> MORTON_TILE_BITS);
+
+        return tile << (2 * MORTON_TILE_BITS) | spread(x & (MORTON_TILE_SIZE - 1)) | spread(y & (MORTON_TILE_SIZE - 1)) << 1;
+
+    }
+
+    static size_t getRecordCount(const int rows, const int cols) {
+        return (size_t) ((rows + MORTON_TILE_SIZE - 1) / MORTON_TILE_SIZE) * ((cols + MORTON_TILE_SIZE - 1) / MORTON_TILE_SIZE) << (2 * MORTON_TILE_BITS);
+    }
+
+private:
+    // moves the low four bits of a coordinate to the even bit positions
+    static int spread(int value) {
+
+        value = (value | value << 2) & 0x33;
+        value = (value | value << 1) & 0x55;
+
+        return value;
+
+    }
+
+    int m_cols;
+    int m_tilesPerRow;
+    int m_shift;
+    uint64_t m_reciprocal;
+
+};
+
+Search::Search(const Graph &graph, const Algorithm algorithm, const Graph::Node start, const Graph::Node target, const Topology topology, std::pmr::memory_resource *resource, const CellLayout layout):
+    m_graph(&graph), m_grid(nullptr), m_topology(isGraphTopology(topology) ? topology : FOUR_CONNECTED), m_layout(layout), m_algorithm(algorithm),
+    m_rows(graph.getRows()), m_cols(graph.getCols()), m_start(start), m_target(target), m_finished(false), m_found(false), m_expansions(0), m_trace(nullptr),
+    m_open(resource), m_head(0), m_cells(resource), m_generation(0) {
+
+    allocate();
+    restart(start, target);
+
+}
+
+Search::Search(const PassageGrid &grid, const Algorithm algorithm, const Graph::Node start, const Graph::Node target, const Topology topology, std::pmr::memory_resource *resource, const CellLayout layout):
+    m_graph(nullptr), m_grid(&grid), m_topology(isGraphTopology(topology) ? VOXEL : topology), m_layout(layout), m_algorithm(algorithm),
+    m_rows(grid.getLayers() * grid.getRows()), m_cols(grid.getCols()), m_start(start), m_target(target), m_finished(false), m_found(false), m_expansions(0), m_trace(nullptr),
+    m_open(resource), m_head(0), m_cells(resource), m_generation(0) {
+
+    allocate();
+    restart(start, target);
+
+}
+
+void Search::allocate() {
+
+    m_jumping = m_algorithm == JPS && m_topology == FOUR_CONNECTED;
+
+    m_straightCost = m_topology == EIGHT_CONNECTED || m_topology == EIGHT_CONNECTED_NO_CORNER_CUTTING ? EightConnected<true>::STRAIGHT_COST : 1;
+    size_t records = m_layout == MORTON_TILES ? MortonTileLayout::getRecordCount(m_rows, m_cols) : (size_t) m_rows * m_cols;
+    m_cells.assign(records, CellRecord { 0, INT_MAX, -1, UNSEEN });
+
+}
+
+void Search::restart(const Graph::Node start, const Graph::Node target) {
+
+    // stamps only repeat after 2^32 queries, then the records are wiped once
+    if(++m_generation == 0) {
+        std::fill(m_cells.begin(), m_cells.end(), CellRecord { 0, INT_MAX, -1, UNSEEN });
+        m_generation = 1;
+    }
+
+    m_open.clear();
+    m_head = 0;
+
+    m_start = start;
+    m_target = target;
+    m_finished = false;
+    m_found = false;
+    m_expansions = 0;
+
+    CellRecord &record = getRecord(getIndex(start.id));
+    record.distance = 0;
+    record.state = FRONTIER;
+    m_open.push_back(std::make_pair(0, start.id));
+
+}
+
+size_t Search::getIndex(const int id) const {
+    return m_layout == MORTON_TILES ? MortonTileLayout(m_cols).getIndex(id) : RowMajorLayout().getIndex(id);
+}
+
+// a record from an older query is reset on first touch
+Search::CellRecord &Search::getRecord(const size_t index) {
+
+    CellRecord &record = m_cells[index];
+    if(record.generation != m_generation) record = CellRecord { m_generation, INT_MAX, -1, UNSEEN };
+
+    return record;
+
+}
+
+const char *Search::getAlgorithmName(const Algorithm algorithm) {
+
+    switch(algorithm) {
+        case DIJKSTRA:
+            return "dijkstra";
+        case A_STAR:
+            return "astar";
+        case BFS:
+            return "bfs";
+        case JPS:
+            return "jps";
+        default:
+            return "unknown";
+    }
+
+}
+
+const char *Search::getLayoutName(const CellLayout layout) {
+
+    switch(layout) {
+        case ROW_MAJOR:
+            return "row";
+        case MORTON_TILES:
+            return "morton";
+        default:
+            return "unknown";
+    }
+
+}
+
+// the one switch on the topology, outside the loop
+bool Search::step(const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited) {
+
+    switch(m_topology) {
+        case FOUR_CONNECTED:
+            expandInLayout(FourConnected(*m_graph), maxExpansions, frontier, visited);
+            break;
+        case EIGHT_CONNECTED:
+            expandInLayout(EightConnected<true>(*m_graph), maxExpansions, frontier, visited);
+            break;
+        case EIGHT_CONNECTED_NO_CORNER_CUTTING:
+            expandInLayout(EightConnected<false>(*m_graph), maxExpansions, frontier, visited);
+            break;
+        case HEX:
+            expandInLayout(HexConnected(*m_grid), maxExpansions, frontier, visited);
+            break;
+        default:
+            expandInLayout(VoxelConnected(*m_grid), maxExpansions, frontier, visited);
+            break;
+    }
+
+    return m_finished;
+
+}
+
+template<class Neighborhood>
+void Search::expandInLayout(const Neighborhood &neighborhood, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited) {
+
+    if(m_jumping && m_layout == MORTON_TILES) expandJumps(MortonTileLayout(m_cols), maxExpansions, frontier, visited);
+    else if(m_jumping) expandJumps(RowMajorLayout(), maxExpansions, frontier, visited);
+    else if(m_layout == MORTON_TILES) expand(neighborhood, MortonTileLayout(m_cols), maxExpansions, frontier, visited);
+    else expand(neighborhood, RowMajorLayout(), maxExpansions, frontier, visited);
+
+}
+
+template<class Neighborhood, class Layout>
+void Search::expand(const Neighborhood &neighborhood, const Layout &layout, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited) {
+
+    // A* on every topology JPS does not cover
+    bool informed = m_algorithm == A_STAR || m_algorithm == JPS;
+
+    for(auto i = 0; i < maxExpansions && !m_finished; i++) {
+
+        if(m_head == m_open.size()) {
+            m_finished = true;
+            if(m_trace) m_trace->exhausted();
+            break;
+        }
+
+        int id;
+
+        if(m_algorithm == BFS) {
+            id = m_open[m_head++].second;
+        } else {
+            std::pop_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+            id = m_open.back().second;
+            m_open.pop_back();
+        }
+
+        // queued cells always carry the current generation
+        CellRecord &record = m_cells[layout.getIndex(id)];
+
+        // stale entry left behind by a later improvement; the heuristics
+        // are consistent, so a cell's first pop is its cheapest
+        if(record.state == VISITED) continue;
+
+        record.state = VISITED;
+        m_expansions++;
+        if(visited) visited->push_back(Graph::Node(id % m_cols, id / m_cols, m_cols));
+        if(m_trace) m_trace->pop(id, record.distance);
+
+        if(id == m_target.id) {
+            m_finished = true;
+            m_found = true;
+            if(m_trace) m_trace->found(getPath());
+            break;
+        }
+
+        int base = record.distance;
+
+        neighborhood.forEachNeighbor(id, [&](const int neighbor, const int cost) {
+
+            int distance = base + cost;
+            CellRecord &next = getRecord(layout.getIndex(neighbor));
+            if(next.state == VISITED || distance >= next.distance) return;
+
+            // breadth first keeps the move count of the first discovery
+            if(m_algorithm == BFS && next.state == FRONTIER) return;
+
+            if(m_trace && next.state == UNSEEN) m_trace->push(neighbor, distance);
+            else if(m_trace) m_trace->relax(neighbor, distance);
+
+            next.distance = distance;
+            next.cameFrom = id;
+            next.state = FRONTIER;
+
+            if(m_algorithm == BFS) {
+                m_open.push_back(std::make_pair(distance, neighbor));
+            } else {
+                m_open.push_back(std::make_pair(informed ? distance + neighborhood.estimate(neighbor, m_target.id) : distance, neighbor));
+                std::push_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+            }
+
+            if(frontier) frontier->push_back(Graph::Node(neighbor % m_cols, neighbor / m_cols, m_cols));
+
+        });
+
+    }
+
+}
+
+// Canonical shortest paths move vertically first and turn horizontal only
+// once, unless a wall forces another turn. So a vertical jump scans both
+// ways sideways at every cell, while a horizontal jump only stops where a
+// vertical neighbour cannot also be reached through the cell behind (a
+// forced neighbour). Only jump points enter the open list.
+template<class Layout>
+void Search::expandJumps(const Layout &layout, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited) {
+
+    FourConnected neighborhood = FourConnected(*m_graph);
+
+    for(auto i = 0; i < maxExpansions && !m_finished; i++) {
+
+        if(m_open.empty()) {
+            m_finished = true;
+            if(m_trace) m_trace->exhausted();
+            break;
+        }
+
+        std::pop_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+        int id = m_open.back().second;
+        m_open.pop_back();
+
+        CellRecord &record = m_cells[layout.getIndex(id)];
+        if(record.state == VISITED) continue;
+
+        record.state = VISITED;
+        m_expansions++;
+        if(visited) visited->push_back(Graph::Node(id % m_cols, id / m_cols, m_cols));
+        if(m_trace) m_trace->pop(id, record.distance);
+
+        if(id == m_target.id) {
+            m_finished = true;
+            m_found = true;
+            if(m_trace) m_trace->found(getPath());
+            break;
+        }
+
+        int x = id % m_cols;
+        int y = id / m_cols;
+        int base = record.distance;
+        int from = record.cameFrom;
+
+        // directions of FourConnected worth jumping in, given how the node was reached
+        bool directions[FourConnected::DIRECTIONS] = { true, true, true, true };
+
+        if(from != -1 && from / m_cols != y) {
+            directions[from / m_cols < y ? 1 : 3] = false;
+        } else if(from != -1) {
+            int forward = from < id ? 2 : 0;
+            int forced = getForcedNeighbors(x, y, forward);
+            directions[2 - forward] = false;
+            directions[1] = forced >> 1 & 1;
+            directions[3] = forced >> 3 & 1;
+        }
+
+        for(auto direction = 0; direction < FourConnected::DIRECTIONS; direction++) {
+
+            if(!directions[direction]) continue;
+
+            int jumpPoint = direction % 2 == 0 ? jumpHorizontal(x, y, direction) : jumpVertical(x, y, direction);
+            if(jumpPoint == -1) continue;
+
+            int distance = base + getLinkMoves(jumpPoint, id);
+            CellRecord &next = getRecord(layout.getIndex(jumpPoint));
+            if(next.state == VISITED || distance >= next.distance) continue;
+
+            if(m_trace && next.state == UNSEEN) m_trace->push(jumpPoint, distance);
+            else if(m_trace) m_trace->relax(jumpPoint, distance);
+
+            next.distance = distance;
+            next.cameFrom = id;
+            next.state = FRONTIER;
+            m_open.push_back(std::make_pair(distance + neighborhood.estimate(jumpPoint, m_target.id), jumpPoint));
+            std::push_heap(m_open.begin(), m_open.end(), std::greater<QueueEntry>());
+            if(frontier) frontier->push_back(Graph::Node(jumpPoint % m_cols, jumpPoint / m_cols, m_cols));
+
+        }
+
+    }
+
+}
+
+int Search::jumpHorizontal(int x, const int y, const int direction) const {
+
+    int dx = FourConnected::OFFSET_X[direction];
+
+    while(FourConnected::isOpen(*m_graph, x, y, direction)) {
+
+        x += dx;
+        if(y * m_cols + x == m_target.id || getForcedNeighbors(x, y, direction)) return y * m_cols + x;
+
+    }
+
+    return -1;
+
+}
+
+int Search::jumpVertical(const int x, int y, const int direction) const {
+
+    int dy = FourConnected::OFFSET_Y[direction];
+
+    while(FourConnected::isOpen(*m_graph, x, y, direction)) {
+
+        y += dy;
+        if(y * m_cols + x == m_target.id || jumpHorizontal(x, y, 0) != -1 || jumpHorizontal(x, y, 2) != -1) return y * m_cols + x;
+
+    }
+
+    return -1;
+
+}
+
+// vertical neighbours open from the cell that cannot be reached as
+// cheaply by turning one cell earlier
+int Search::getForcedNeighbors(const int x, const int y, const int direction) const {
+
+    int behind = x - FourConnected::OFFSET_X[direction];
+    int forced = 0;
+
+    for(auto vertical = 1; vertical < FourConnected::DIRECTIONS; vertical += 2) {
+
+        if(!FourConnected::isOpen(*m_graph, x, y, vertical)) continue;
+        if(!FourConnected::isOpen(*m_graph, behind, y, vertical) || !FourConnected::isOpen(*m_graph, behind, y + FourConnected::OFFSET_Y[vertical], direction)) forced |= 1 << vertical;
+
+    }
+
+    return forced;
+
+}
+
+int Search::getLinkMoves(const int id, const int from) const {
+    return m_jumping ? std::abs(id % m_cols - from % m_cols) + std::abs(id / m_cols - from / m_cols) : 1;
+}
+
+void Search::setTrace(TraceWriter *trace) {
+    m_trace = trace;
+}
+
+bool Search::isFinished() const {
+    return m_finished;
+}
+
+bool Search::hasPath() const {
+    return m_found;
+}
+
+// start to target, empty if no path was found
+vector<Graph::Node> Search::getPath() const {
+
+    vector<Graph::Node> path;
+    getPath(&path);
+
+    return path;
+
+}
+
+void Search::getPath(vector<Graph::Node> *path) const {
+
+    path->clear();
+    if(!m_found) return;
+
+    for(int id = m_target.id; id != -1; id = m_cells[getIndex(id)].cameFrom) {
+
+        path->push_back(Graph::Node(id % m_cols, id / m_cols, m_cols));
+
+        // jump point links skip the cells of a straight run
+        int from = m_cells[getIndex(id)].cameFrom;
+        if(!m_jumping || from == -1) continue;
+
+        int step = from / m_cols == id / m_cols ? (from < id ? -1 : 1) : (from < id ? -m_cols : m_cols);
+        for(int cell = id + step; cell != from; cell += step) path->push_back(Graph::Node(cell % m_cols, cell / m_cols, m_cols));
+
+    }
+
+    std::reverse(path->begin(), path->end());
+
+}
+
+int Search::getPathLength() const {
+
+    if(!m_found) return -1;
+
+    int moves = 0;
+    for(int id = m_target.id; id != m_start.id; id = m_cells[getIndex(id)].cameFrom) moves += getLinkMoves(id, m_cells[getIndex(id)].cameFrom);
+
+    return moves;
+
+}
+
+double Search::getPathCost() const {
+
+    if(!m_found) return -1.0;
+
+    int distance = m_cells[getIndex(m_target.id)].distance;
+    if(m_straightCost == 1) return distance;
+
+    // split the fixed point distance into its moves, so a diagonal counts sqrt(2)
+    int moves = getPathLength();
+    int diagonals = (distance - moves * m_straightCost) / (EightConnected<true>::DIAGONAL_COST - m_straightCost);
+
+    return (moves - diagonals) + diagonals * std::sqrt(2.0);
+
+}
+
+Search::CellState Search::getState(const Graph::Node node) const {
+
+    const CellRecord &record = m_cells[getIndex(node.id)];
+
+    return record.generation == m_generation ? record.state : UNSEEN;
+
+}
+
+int Search::getDistance(const Graph::Node node) const {
+
+    const CellRecord &record = m_cells[getIndex(node.id)];
+
+    return record.generation == m_generation ? record.distance : INT_MAX;
+
+}
+
+int Search::getExpansions() const {
+    return m_expansions;
+}
+
+int Search::getRows() const {
+    return m_rows;
+}
+
+int Search::getCols() const {
+    return m_cols;
+}
+
+Topology Search::getTopology() const {
+    return m_topology;
+}
+
+Search::CellLayout Search::getLayout() const {
+    return m_layout;
+}
+
+size_t Search::getMemoryUsage() const {
+    return getCapacityBytes(m_open) + getCapacityBytes(m_cells);
+}
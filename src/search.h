@@ -0,0 +1,153 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "graph.h"
+#include "memory.h"
+#include "topology.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+class TraceWriter;
+
+// Incremental shortest path search over a Graph, or over a PassageGrid for
+// hex and voxel maps. step() expands a bounded number of nodes so the
+// caller can animate the search frame by frame. Breadth first search
+// finds the fewest moves, which is only the cheapest path where all moves
+// cost the same; jump point search needs a 4-connected Graph and runs as
+// A* anywhere else. Nodes of a PassageGrid
+// use its floors stacked top to bottom as rows. All per-cell buffers come
+// from the given memory resource, typically a SearchArena reset between
+// queries; by default they are counted as MEMORY_SEARCH.
+class Search {
+
+public:
+    enum Algorithm {
+        DIJKSTRA,
+        A_STAR,
+        BFS,
+        JPS,
+        ALGORITHM_COUNT
+    };
+
+    // How the per-cell records are ordered in memory. Node ids stay row
+    // major either way; MORTON_TILES stores 16x16 blocks of cells in 4 KB
+    // each, Z-ordered inside, so a cell's vertical neighbours usually share
+    // its page instead of lying a whole row of records away.
+    enum CellLayout {
+        ROW_MAJOR,
+        MORTON_TILES,
+        LAYOUT_COUNT
+    };
+
+    enum CellState : uint8_t {
+        UNSEEN,
+        FRONTIER,
+        VISITED
+    };
+
+    // topologies that do not fit the storage fall back to FOUR_CONNECTED for a Graph and to VOXEL for a PassageGrid
+    Search(const Graph &graph, const Algorithm algorithm, const Graph::Node start, const Graph::Node target, const Topology topology = FOUR_CONNECTED, std::pmr::memory_resource *resource = getTrackingResource(MEMORY_SEARCH), const CellLayout layout = ROW_MAJOR);
+    Search(const PassageGrid &grid, const Algorithm algorithm, const Graph::Node start, const Graph::Node target, const Topology topology, std::pmr::memory_resource *resource = getTrackingResource(MEMORY_SEARCH), const CellLayout layout = ROW_MAJOR);
+
+    // lower case identifier used on command lines and in reports
+    static const char *getAlgorithmName(const Algorithm algorithm);
+    static const char *getLayoutName(const CellLayout layout);
+
+    // starts over from a new start and target on the same graph in O(1):
+    // the buffers are kept and every cell of older queries reads as unseen
+    void restart(const Graph::Node start, const Graph::Node target);
+
+    // records every following event, or stops recording for nullptr
+    void setTrace(TraceWriter *trace);
+
+    // returns true once the search has finished; frontier and visited
+    // receive the nodes that entered that state during this step
+    bool step(const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited);
+
+    bool isFinished() const;
+    bool hasPath() const;
+    vector<Graph::Node> getPath() const;
+    // the same into an existing vector, reusing its capacity
+    void getPath(vector<Graph::Node> *path) const;
+    // moves along the path, or -1 without one
+    int getPathLength() const;
+    // the path's cost in straight moves, so diagonals count about 1.4; -1 without a path
+    double getPathCost() const;
+
+    CellState getState(const Graph::Node node) const;
+    int getDistance(const Graph::Node node) const;
+    int getExpansions() const;
+    int getRows() const;
+    int getCols() const;
+    Topology getTopology() const;
+    CellLayout getLayout() const;
+    size_t getMemoryUsage() const;
+
+private:
+    typedef std::pair<int, int> QueueEntry;
+
+    // everything the search knows about a cell, valid only while the
+    // generation matches the current query's
+    struct CellRecord {
+        uint32_t generation;
+        int distance;
+        int cameFrom;
+        CellState state;
+    };
+
+    void allocate();
+    // record index of a node id, for code outside the search loop
+    size_t getIndex(const int id) const;
+    inline CellRecord &getRecord(const size_t index);
+
+    // the search loop, compiled once per neighbourhood and layout
+    template<class Neighborhood>
+    void expandInLayout(const Neighborhood &neighborhood, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited);
+    template<class Neighborhood, class Layout>
+    void expand(const Neighborhood &neighborhood, const Layout &layout, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited);
+
+    // jump point search on a 4-connected Graph; a jump returns the next
+    // jump point in a direction of FourConnected, or -1
+    template<class Layout>
+    void expandJumps(const Layout &layout, const int maxExpansions, vector<Graph::Node> *frontier, vector<Graph::Node> *visited);
+    int jumpHorizontal(int x, const int y, const int direction) const;
+    int jumpVertical(const int x, int y, const int direction) const;
+    // bit set of the vertical directions forced at a cell entered horizontally
+    int getForcedNeighbors(const int x, const int y, const int direction) const;
+    // moves between a node and the one it was reached from
+    int getLinkMoves(const int id, const int from) const;
+
+    const Graph *m_graph;
+    const PassageGrid *m_grid;
+    Topology m_topology;
+    CellLayout m_layout;
+    int m_straightCost;
+    Algorithm m_algorithm;
+    // JPS on a 4-connected Graph, whose links span whole straight runs
+    bool m_jumping;
+    int m_rows;
+    int m_cols;
+    Graph::Node m_start;
+    Graph::Node m_target;
+    bool m_finished;
+    bool m_found;
+    int m_expansions;
+    TraceWriter *m_trace;
+
+    // binary heap of (priority, node id), smallest first; a plain vector
+    // so restart() keeps its capacity. Breadth first search uses it as a
+    // FIFO queue read from m_head instead.
+    std::pmr::vector<QueueEntry> m_open;
+    size_t m_head;
+    std::pmr::vector<CellRecord> m_cells;
+    uint32_t m_generation;
+
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "snapshot.h"
+
+#include <algorithm>
+
+// the hazard announcements and the pointer swap are sequentially consistent: either the
+// writer sees a reader's announcement, or the reader sees the swap and retries
+
+GraphVersions::GraphVersions(const Graph &graph): m_latest(nullptr), m_number(0) {
+
+    for(auto &hazard : m_hazards) hazard.store(nullptr);
+
+    publish(graph);
+
+}
+
+GraphVersions::~GraphVersions() {
+
+    delete m_latest.load();
+    for(Entry *entry : m_retired) delete entry;
+
+}
+
+uint64_t GraphVersions::publish(const Graph &graph) {
+
+    m_number++;
+
+    Entry *replaced = m_latest.exchange(new Entry { std::make_shared<const GraphVersion>(GraphVersion { m_number, graph }) });
+    if(replaced) m_retired.push_back(replaced);
+
+    reclaim();
+
+    return m_number;
+
+}
+
+std::shared_ptr<const GraphVersion> GraphVersions::pin() const {
+
+    const Entry *entry = m_latest.load();
+
+    // claim a free slot by announcing the entry in it
+    size_t slot = 0;
+    for(const Entry *expected = nullptr; !m_hazards[slot].compare_exchange_weak(expected, entry); expected = nullptr) {
+        slot = (slot + 1) % GRAPH_VERSION_HAZARD_SLOTS;
+    }
+
+    // the entry is safe once it is still the latest after being announced
+    for(const Entry *latest = m_latest.load(); latest != entry; latest = m_latest.load()) {
+        entry = latest;
+        m_hazards[slot].store(entry);
+    }
+
+    std::shared_ptr<const GraphVersion> version = entry->version;
+    m_hazards[slot].store(nullptr, std::memory_order_release);
+
+    return version;
+
+}
+
+// frees the replaced entries no reader announces; the rest wait for the next publish
+void GraphVersions::reclaim() {
+
+    auto end = std::remove_if(m_retired.begin(), m_retired.end(), [this](Entry *entry) {
+
+        for(const auto &hazard : m_hazards) {
+            if(hazard.load() == entry) return false;
+        }
+
+        delete entry;
+        return true;
+
+    });
+
+    m_retired.erase(end, m_retired.end());
+
+}
+
+std::shared_ptr<const Graph> getSnapshotGraph(const std::shared_ptr<const GraphVersion> &version) {
+    return std::shared_ptr<const Graph>(version, &version->graph);
+}
@@ -0,0 +1,66 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "graph.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using std::vector;
+
+// readers pinning at the same moment; a further one waits for a slot, never for the writer
+#define GRAPH_VERSION_HAZARD_SLOTS 64
+
+// One published state of a graph, never modified once published.
+struct GraphVersion {
+    uint64_t number;
+    Graph graph;
+};
+
+// Hands versions of a graph edited on one thread to readers on others.
+// The writer publishes a copy after a batch of edits; the copy shares every
+// band with the edited graph, so publishing costs the band table and the
+// next edits clone only the bands they touch.
+//
+// Nothing here takes a lock. The latest version sits behind an atomic raw
+// pointer. A reader announces the pointer it is about to follow in a hazard
+// slot, checks it is still the latest, then takes its own reference and
+// clears the slot; a publish racing with it only makes it retry. The writer
+// swaps the pointer and frees replaced entries no slot announces, keeping
+// the others for a later publish, so it never waits for readers either.
+class GraphVersions {
+
+public:
+    explicit GraphVersions(const Graph &graph);
+    // no reader may be pinning any more
+    ~GraphVersions();
+
+    GraphVersions(const GraphVersions&) = delete;
+    GraphVersions &operator=(const GraphVersions&) = delete;
+
+    // writer thread only; returns the new version's number
+    uint64_t publish(const Graph &graph);
+    // any thread; the version stays alive as long as the returned pointer
+    std::shared_ptr<const GraphVersion> pin() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const GraphVersion> version;
+    };
+
+    void reclaim();
+
+    std::atomic<Entry*> m_latest;
+    mutable std::atomic<const Entry*> m_hazards[GRAPH_VERSION_HAZARD_SLOTS];
+    // replaced entries a reader may still be following, writer thread only
+    vector<Entry*> m_retired;
+    uint64_t m_number;
+
+};
+
+// the graph of a pinned version, keeping the version alive
+std::shared_ptr<const Graph> getSnapshotGraph(const std::shared_ptr<const GraphVersion> &version);
+
+#endif
@@ -0,0 +1,489 @@
+#include "edits.h"
+#include "flowfield.h"
+#include "graph.h"
+#include "maze.h"
+#include "mazefile.h"
+#include "search.h"
+#include "snapshot.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Round-trip and stress checks for the core library, one ctest entry per
+// test. Each test builds its own graphs from fixed seeds and writes its
+// files into the working directory under its own name, so the tests may
+// run in parallel.
+
+#define CHECK(condition) if(!(condition)) { std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); return false; }
+
+using std::vector;
+
+struct TestCase {
+    const char *name;
+    bool (*run)();
+};
+
+// FNV-1a over the size and every passage word
+uint64_t getChecksum(const Graph &graph) {
+
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](const uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+
+    mix(graph.getRows());
+    mix(graph.getCols());
+
+    for(auto y = 0; y < graph.getRows(); y++) {
+        for(auto word = 0; word < graph.getWordsPerRow(); word++) {
+            mix(graph.getPassageWord(Graph::RIGHT, y, word));
+            mix(graph.getPassageWord(Graph::DOWN, y, word));
+        }
+    }
+
+    return hash;
+
+}
+
+Graph makeMaze(const int rows, const int cols, const uint32_t seed) {
+
+    Graph graph = Graph(rows, cols);
+    generateMaze(&graph, KRUSKAL, seed);
+
+    return graph;
+
+}
+
+Graph::Node randomNode(const Graph &graph, std::mt19937 *random) {
+    return Graph::Node((*random)() % graph.getCols(), (*random)() % graph.getRows(), graph.getCols());
+}
+
+// opens or closes the passage between a random cell and its right or lower neighbour
+void randomEdit(Graph *graph, std::mt19937 *random) {
+
+    Graph::Node node = randomNode(*graph, random);
+    bool right = (*random)() % 2;
+    if(right ? node.x + 1 >= graph->getCols() : node.y + 1 >= graph->getRows()) return;
+
+    Graph::Node other = Graph::Node(node.x + right, node.y + !right, graph->getCols());
+
+    if((*random)() % 2) graph->addEdge(node, other);
+    else graph->removeEdge(node, other);
+
+}
+
+// a few lines and small rectangles, as one brush stroke would give
+void queueRandomEdits(const Graph &graph, EditBuffer *edits, std::mt19937 *random) {
+
+    for(auto i = 0; i < 4; i++) {
+
+        Graph::Node a = randomNode(graph, random);
+        Graph::Node b = Graph::Node(std::min<int>(a.x + (*random)() % 6, graph.getCols() - 1), std::min<int>(a.y + (*random)() % 6, graph.getRows() - 1), graph.getCols());
+
+        switch((*random)() % 4) {
+            case 0:
+                edits->connectLine(a, b);
+                break;
+            case 1:
+                edits->isolateLine(a, b);
+                break;
+            case 2:
+                edits->fillRect(a, b);
+                break;
+            default:
+                edits->clearRect(a, b);
+                break;
+        }
+
+    }
+
+}
+
+// copies share bands until either side writes, and writes never reach the other side
+bool testGraphCopyOnWrite() {
+
+    Graph graph = makeMaze(100, 130, 1);
+    uint64_t original = getChecksum(graph);
+
+    Graph copy = graph;
+    CHECK(getChecksum(copy) == original);
+
+    std::mt19937 random = std::mt19937(2);
+    for(auto i = 0; i < 500; i++) randomEdit(&graph, &random);
+    graph.removeAllNeighbors(Graph::Node(64, 40, graph.getCols()));
+    uint64_t edited = getChecksum(graph);
+
+    CHECK(edited != original);
+    CHECK(getChecksum(copy) == original);
+
+    copy.fillRect(10, 10, 90, 70);
+    CHECK(getChecksum(graph) == edited);
+
+    Graph second = graph;
+    second = copy;
+    CHECK(getChecksum(second) == getChecksum(copy));
+    second.clearRect(0, 0, 130, 100);
+    CHECK(getChecksum(copy) != getChecksum(second));
+    CHECK(getChecksum(graph) == edited);
+
+    // a resize only replaces the resized graph's bands
+    Graph resized = graph;
+    resized.resize(20, 20);
+    CHECK(getChecksum(graph) == edited);
+
+    return true;
+
+}
+
+// readers pin, copy and edit published versions while the writer keeps
+// editing and publishing; every version must read as it was published
+bool testSnapshotStress() {
+
+    const int publishes = 2000;
+    const int readers = 4;
+
+    Graph graph = makeMaze(200, 300, 3);
+    vector<std::atomic<uint64_t>> checksums = vector<std::atomic<uint64_t>>(publishes + 2);
+    checksums[1] = getChecksum(graph);
+
+    GraphVersions versions = GraphVersions(graph);
+    std::atomic<bool> done = std::atomic<bool>(false);
+    std::atomic<int> failures = std::atomic<int>(0);
+    std::atomic<int> pins = std::atomic<int>(0);
+    vector<std::thread> threads;
+
+    for(auto reader = 0; reader < readers; reader++) {
+
+        threads.emplace_back([&, reader]() {
+
+            std::mt19937 random = std::mt19937(100 + reader);
+            uint64_t last = 0;
+
+            while(!done) {
+
+                std::shared_ptr<const GraphVersion> version = versions.pin();
+                pins++;
+
+                if(version->number < last || getChecksum(version->graph) != checksums[version->number]) failures++;
+                last = version->number;
+
+                // a copy made here clears flags on the published graph while the writer copies it too
+                if(random() % 4 == 0) {
+                    Graph copy = version->graph;
+                    randomEdit(&copy, &random);
+                    copy.fillRect(0, 0, 8, 8);
+                    if(getChecksum(version->graph) != checksums[version->number]) failures++;
+                }
+
+            }
+
+        });
+
+    }
+
+    std::mt19937 random = std::mt19937(4);
+    bool numbered = true;
+
+    for(auto publish = 2; publish <= publishes + 1; publish++) {
+
+        for(auto i = 0; i < 50; i++) randomEdit(&graph, &random);
+
+        checksums[publish] = getChecksum(graph);
+        numbered = numbered && versions.publish(graph) == (uint64_t) publish;
+
+    }
+
+    // make sure every reader got some pins in, even on a single core
+    while(pins < 4 * readers) std::this_thread::yield();
+    done = true;
+    for(std::thread &thread : threads) thread.join();
+
+    CHECK(numbered);
+    CHECK(failures == 0);
+    CHECK(versions.pin()->number == (uint64_t) publishes + 1);
+    CHECK(getChecksum(versions.pin()->graph) == getChecksum(graph));
+
+    return true;
+
+}
+
+bool testMazeFileRoundTrip() {
+
+    const char *path = "test-mazefile.maze";
+    const uint16_t formats[] = { 0, MAZE_FILE_RLE, MAZE_FILE_MAPPABLE };
+
+    // 50 columns leave padding bits in every row, 70 rows a partial band
+    Graph graph = makeMaze(70, 50, 5);
+    graph.fillRect(3, 3, 20, 12);
+    uint64_t original = getChecksum(graph);
+
+    for(uint16_t flags : formats) {
+
+        CHECK(saveMaze(graph, path, flags));
+
+        Graph loaded = Graph(1, 1);
+        CHECK(loadMaze(&loaded, path));
+        CHECK(getChecksum(loaded) == original);
+
+        if(flags != MAZE_FILE_MAPPABLE) continue;
+
+#ifndef _WIN32
+        CHECK(loaded.isShared());
+#endif
+
+        // edits copy the mapped bands and leave the file as it was
+        loaded.clearRect(0, 0, 50, 40);
+        CHECK(getChecksum(loaded) != original);
+
+        Graph reloaded = Graph(1, 1);
+        CHECK(loadMaze(&reloaded, path));
+        CHECK(getChecksum(reloaded) == original);
+
+    }
+
+    // a passage out of the grid's right border is not mapped but read, which drops it
+    {
+        std::fstream file = std::fstream(path, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t word;
+        file.seekg(4096);
+        file.read((char*) &word, sizeof(word));
+        word |= 1ull << 49;
+        file.seekp(4096);
+        file.write((const char*) &word, sizeof(word));
+    }
+
+    Graph loaded = Graph(1, 1);
+    CHECK(loadMaze(&loaded, path));
+    CHECK(!loaded.isShared());
+    CHECK(getChecksum(loaded) == original);
+
+    std::remove(path);
+
+    return true;
+
+}
+
+bool testJournalUndoRedo() {
+
+    Graph graph = makeMaze(60, 90, 6);
+    EditJournal journal = EditJournal(1 << 20);
+    EditBuffer edits;
+    AppliedEdits applied;
+    std::mt19937 random = std::mt19937(7);
+
+    // the graph after every committed transaction
+    vector<uint64_t> states = { getChecksum(graph) };
+
+    for(auto stroke = 0; stroke < 40; stroke++) {
+
+        size_t transactions = journal.getTransactionCount();
+
+        queueRandomEdits(graph, &edits, &random);
+        applied.clear();
+        edits.apply(&graph, &journal, &applied);
+        journal.commit();
+
+        if(journal.getTransactionCount() > transactions) states.push_back(getChecksum(graph));
+
+    }
+
+    CHECK(states.size() > 20);
+
+    for(size_t state = states.size() - 1; state > 0; state--) {
+        applied.clear();
+        CHECK(journal.undo(&graph, &applied));
+        CHECK(!applied.isEmpty());
+        CHECK(getChecksum(graph) == states[state - 1]);
+    }
+
+    CHECK(!journal.canUndo());
+
+    for(size_t state = 1; state < states.size(); state++) {
+        applied.clear();
+        CHECK(journal.redo(&graph, &applied));
+        CHECK(getChecksum(graph) == states[state]);
+    }
+
+    CHECK(!journal.canRedo());
+
+    // a new transaction after undoing drops the redo history
+    CHECK(journal.undo(&graph, &applied));
+    graph.removeAllNeighbors(Graph::Node(0, 0, graph.getCols()));
+    edits.clearRect(Graph::Node(0, 0, graph.getCols()), Graph::Node(5, 5, graph.getCols()));
+    edits.apply(&graph, &journal, &applied);
+    journal.commit();
+    CHECK(!journal.canRedo());
+
+    return true;
+
+}
+
+// every repaired field must match a freshly computed one
+bool testFlowFieldRepair() {
+
+    Graph graph = makeMaze(80, 120, 8);
+    EditJournal journal = EditJournal(1 << 20);
+    EditBuffer edits;
+    AppliedEdits applied;
+    std::mt19937 random = std::mt19937(9);
+
+    FlowField field;
+    field.compute(graph, Graph::Node(60, 40, graph.getCols()));
+
+    for(auto round = 0; round < 200; round++) {
+
+        queueRandomEdits(graph, &edits, &random);
+        applied.clear();
+        edits.apply(&graph, &journal, &applied);
+        journal.commit();
+
+        // some rounds also undo, the same frame repairing both as the visualizer does
+        if(round % 5 == 4) journal.undo(&graph, &applied);
+
+        field.repair(graph, applied);
+
+        FlowField fresh;
+        fresh.compute(graph, field.getTarget());
+
+        for(auto y = 0; y < graph.getRows(); y++) {
+            for(auto x = 0; x < graph.getCols(); x++) {
+
+                Graph::Node node = Graph::Node(x, y, graph.getCols());
+                int distance = field.getDistance(node);
+                CHECK(distance == fresh.getDistance(node));
+
+                // directions may pick another of several equally short ways, but must be one
+                if(distance > 0) {
+                    Graph::Node next = field.next(node);
+                    CHECK(graph.hasEdge(node, next));
+                    CHECK(field.getDistance(next) == distance - 1);
+                }
+
+            }
+        }
+
+    }
+
+    return true;
+
+}
+
+// replaying a recorded search forwards reaches its final cell states, and
+// seeking backwards and forwards again passes through the same states
+bool testTraceSeek() {
+
+    const char *file = "test-trace.pft";
+
+    Graph graph = makeMaze(90, 110, 10);
+    Graph::Node start = Graph::Node(0, 0, graph.getCols());
+    Graph::Node target = Graph::Node(109, 89, graph.getCols());
+
+    // several keyframe blocks long
+    Search search = Search(graph, Search::DIJKSTRA, start, target);
+    TraceWriter writer;
+    CHECK(writer.open(file, graph.getRows(), graph.getCols(), start, target));
+    search.setTrace(&writer);
+    while(!search.step(INT32_MAX, nullptr, nullptr));
+    writer.close();
+
+    CHECK(search.hasPath());
+    CHECK(writer.getEventCount() > 3 * TRACE_KEYFRAME_INTERVAL);
+
+    TracePlayer player;
+    CHECK(player.open(file));
+    CHECK(player.getEventCount() == writer.getEventCount());
+    CHECK(player.getStart() == start && player.getTarget() == target);
+
+    size_t cells = (size_t) graph.getRows() * graph.getCols();
+    // the start is on the frontier before the first event, as the visualizer shows it
+    vector<Search::CellState> states = vector<Search::CellState>(cells, Search::UNSEEN);
+    states[start.id] = Search::FRONTIER;
+    vector<TraceChange> changes;
+
+    auto seek = [&](const size_t position) {
+
+        changes.clear();
+        player.seek(position, &changes);
+
+        bool consistent = true;
+
+        for(const TraceChange &change : changes) {
+            consistent = consistent && states[change.cell] == change.before;
+            states[change.cell] = change.after;
+        }
+
+        return consistent;
+
+    };
+
+    CHECK(seek(player.getEventCount()));
+    CHECK(player.isPathShown());
+
+    for(size_t id = 0; id < cells; id++) {
+        CHECK(states[id] == search.getState(Graph::Node(id % graph.getCols(), id / graph.getCols(), graph.getCols())));
+    }
+
+    vector<Graph::Node> path;
+    search.getPath(&path);
+    CHECK(player.getPath().size() == path.size());
+    for(size_t i = 0; i < path.size(); i++) CHECK(player.getPath()[i] == path[i]);
+
+    // the same position reached from either side reads the same
+    size_t middle = player.getEventCount() / 2 + 17;
+    CHECK(seek(middle));
+    vector<Search::CellState> backwards = states;
+
+    CHECK(seek(1));
+    CHECK(seek(middle));
+    CHECK(states == backwards);
+
+    CHECK(seek(0));
+    CHECK(!player.isPathShown());
+    for(size_t id = 0; id < cells; id++) CHECK(states[id] == ((int) id == start.id ? Search::FRONTIER : Search::UNSEEN));
+
+    std::remove(file);
+
+    return true;
+
+}
+
+const TestCase TESTS[] = {
+    { "graph-copy-on-write", testGraphCopyOnWrite },
+    { "snapshot-stress", testSnapshotStress },
+    { "mazefile-round-trip", testMazeFileRoundTrip },
+    { "journal-undo-redo", testJournalUndoRedo },
+    { "flowfield-repair", testFlowFieldRepair },
+    { "trace-seek", testTraceSeek }
+};
+
+int main(int argc, char **argv) {
+
+    int failures = 0;
+    int runs = 0;
+
+    for(const TestCase &test : TESTS) {
+
+        if(argc > 1 && std::strcmp(argv[1], test.name) != 0) continue;
+
+        bool passed = test.run();
+        std::printf("%s: %s\n", test.name, passed ? "passed" : "FAILED");
+
+        runs++;
+        if(!passed) failures++;
+
+    }
+
+    if(runs == 0) {
+        std::fprintf(stderr, "usage: pathfinding-tests [test]\n");
+        return 2;
+    }
+
+    return failures > 0 ? 1 : 0;
+
+}
@@ -0,0 +1,148 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(const int threads): m_task(nullptr), m_grain(1), m_generation(0), m_busy(0), m_stopping(false) {
+
+    int workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+
+    for(auto i = 0; i < workers; i++) m_queues.push_back(std::make_unique<WorkQueue>());
+    for(auto i = 1; i < workers; i++) m_threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+
+}
+
+WorkStealingPool::~WorkStealingPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+    for(std::thread &thread : m_threads) thread.join();
+
+}
+
+void WorkStealingPool::parallelFor(const size_t count, const size_t grain, const std::function<void(int, size_t)> &task) {
+
+    if(count == 0) return;
+
+    size_t workers = m_queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // every worker starts with an equal share, stealing evens out the rest
+        for(size_t i = 0; i < workers; i++) {
+            size_t begin = count * i / workers;
+            size_t end = count * (i + 1) / workers;
+            if(begin < end) give(i, Range(begin, end));
+        }
+
+        m_task = &task;
+        m_grain = std::max<size_t>(grain, 1);
+        m_generation++;
+        m_busy++;
+    }
+
+    m_wake.notify_all();
+    drain(0, task, m_grain);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_busy--;
+    m_done.wait(lock, [&]() { return m_busy == 0; });
+    m_task = nullptr;
+
+}
+
+int WorkStealingPool::getWorkerCount() const {
+    return m_queues.size();
+}
+
+void WorkStealingPool::workerLoop(const int worker) {
+
+    size_t seen = 0;
+
+    while(true) {
+
+        const std::function<void(int, size_t)> *task;
+        size_t grain;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stopping || (m_task && m_generation != seen); });
+            if(m_stopping) return;
+
+            seen = m_generation;
+            task = m_task;
+            grain = m_grain;
+            m_busy++;
+        }
+
+        drain(worker, *task, grain);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy--;
+        }
+
+        m_done.notify_all();
+
+    }
+
+}
+
+// runs ranges until no queue has any left; all queues are empty once every worker got here
+void WorkStealingPool::drain(const int worker, const std::function<void(int, size_t)> &task, const size_t grain) {
+
+    Range range;
+
+    while(take(worker, &range)) {
+
+        // keep the front half, the back half stays available to thieves
+        while(range.second - range.first > grain) {
+            size_t middle = range.first + (range.second - range.first) / 2;
+            give(worker, Range(middle, range.second));
+            range.second = middle;
+        }
+
+        for(size_t i = range.first; i < range.second; i++) task(worker, i);
+
+    }
+
+}
+
+bool WorkStealingPool::take(const int worker, Range *range) {
+
+    int workers = m_queues.size();
+
+    for(auto i = 0; i < workers; i++) {
+
+        WorkQueue &queue = *m_queues[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if(queue.ranges.empty()) continue;
+
+        // own work from the back (most recently split, still in cache), stolen work from the front (largest)
+        if(i == 0) {
+            *range = queue.ranges.back();
+            queue.ranges.pop_back();
+        } else {
+            *range = queue.ranges.front();
+            queue.ranges.pop_front();
+        }
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+void WorkStealingPool::give(const int worker, const Range range) {
+
+    std::lock_guard<std::mutex> lock(m_queues[worker]->mutex);
+    m_queues[worker]->ranges.push_back(range);
+
+}
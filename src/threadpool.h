@@ -0,0 +1,64 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+// Fixed set of worker threads running parallel loops. Every worker owns a
+// deque of index ranges: it splits its own ranges from the back and, once
+// it runs dry, steals the largest remaining range from the front of
+// another worker's deque, so uneven work spreads out without a shared queue.
+class WorkStealingPool {
+
+public:
+    // 0 picks one worker per hardware thread; the calling thread is worker 0
+    WorkStealingPool(const int threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool&) = delete;
+
+    // calls task(worker, index) for every index below count and returns once
+    // all calls are done; ranges are split down to grain indices
+    void parallelFor(const size_t count, const size_t grain, const std::function<void(int, size_t)> &task);
+
+    int getWorkerCount() const;
+
+private:
+    typedef std::pair<size_t, size_t> Range;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void workerLoop(const int worker);
+    void drain(const int worker, const std::function<void(int, size_t)> &task, const size_t grain);
+    bool take(const int worker, Range *range);
+    void give(const int worker, const Range range);
+
+    vector<std::thread> m_threads;
+    vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    // guards the fields below, which describe the loop currently running
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(int, size_t)> *m_task;
+    size_t m_grain;
+    size_t m_generation;
+    int m_busy;
+    bool m_stopping;
+
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "topology.h"
+
+#include <algorithm>
+
+const char *getTopologyName(const Topology topology) {
+
+    switch(topology) {
+        case FOUR_CONNECTED:
+            return "four";
+        case EIGHT_CONNECTED:
+            return "eight";
+        case EIGHT_CONNECTED_NO_CORNER_CUTTING:
+            return "eight-strict";
+        case HEX:
+            return "hex";
+        case VOXEL:
+            return "voxel";
+        default:
+            return "unknown";
+    }
+
+}
+
+bool isGraphTopology(const Topology topology) {
+    return topology == FOUR_CONNECTED || topology == EIGHT_CONNECTED || topology == EIGHT_CONNECTED_NO_CORNER_CUTTING;
+}
+
+PassageGrid::PassageGrid(const int layers, const int rows, const int cols): m_layers(std::max(layers, 0)), m_rows(std::max(rows, 0)), m_cols(std::max(cols, 0)), m_passages((size_t) m_layers * m_rows * m_cols, 0) {}
+
+// the caller keeps to owned directions whose neighbour exists in its topology
+void PassageGrid::setPassage(const int id, const int direction, const bool open) {
+
+    if(open) m_passages[id] |= 1 << direction;
+    else m_passages[id] &= ~(1 << direction);
+
+}
+
+void PassageGrid::clear() {
+    std::fill(m_passages.begin(), m_passages.end(), 0);
+}
+
+int PassageGrid::getLayers() const {
+    return m_layers;
+}
+
+int PassageGrid::getRows() const {
+    return m_rows;
+}
+
+int PassageGrid::getCols() const {
+    return m_cols;
+}
+
+size_t PassageGrid::getCellCount() const {
+    return m_passages.size();
+}
+
+size_t PassageGrid::getMemoryUsage() const {
+    return getCapacityBytes(m_passages);
+}
@@ -0,0 +1,296 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include "graph.h"
+#include "memory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using std::vector;
+
+// Neighbourhoods the search can run on. Each one has a policy class below
+// whose neighbour offsets are fixed at compile time; the search is
+// instantiated once per policy, so its inner loop never branches on the
+// topology.
+enum Topology {
+    FOUR_CONNECTED,
+    EIGHT_CONNECTED,
+    EIGHT_CONNECTED_NO_CORNER_CUTTING,
+    HEX,
+    VOXEL,
+    TOPOLOGY_COUNT
+};
+
+// lower case identifier used on command lines and in reports
+const char *getTopologyName(const Topology topology);
+
+// the 2D square topologies read a Graph, hex and voxel maps a PassageGrid
+bool isGraphTopology(const Topology topology);
+
+// Passages of a hex or multi-floor map. Every cell owns its passages in
+// the first three directions of its topology (one bit each), the other
+// three belong to the neighbour on that side. Cell ids run floor by floor,
+// so a voxel map reads as its floors stacked top to bottom.
+class PassageGrid {
+
+public:
+    PassageGrid(const int layers, const int rows, const int cols);
+
+    inline uint8_t getPassages(const int id) const;
+    void setPassage(const int id, const int direction, const bool open);
+    void clear();
+
+    int getLayers() const;
+    int getRows() const;
+    int getCols() const;
+    size_t getCellCount() const;
+    size_t getMemoryUsage() const;
+
+private:
+    int m_layers;
+    int m_rows;
+    int m_cols;
+    TrackedVector<uint8_t, MEMORY_GRAPH> m_passages;
+
+};
+
+uint8_t PassageGrid::getPassages(const int id) const {
+    return m_passages[id];
+}
+
+inline bool testBit(const uint64_t *words, const int bit) {
+    return (words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+// Left, up, right, down, the order Graph::getNeighbors uses.
+class FourConnected {
+
+public:
+    static constexpr int DIRECTIONS = 4;
+    static constexpr int STRAIGHT_COST = 1;
+    static constexpr int OFFSET_X[DIRECTIONS] = { -1, 0, 1, 0 };
+    static constexpr int OFFSET_Y[DIRECTIONS] = { 0, -1, 0, 1 };
+
+    FourConnected(const Graph &graph): m_graph(graph), m_cols(graph.getCols()) {}
+
+    // calls visit(neighbor id, step cost) for every open neighbour
+    template<class Visit>
+    void forEachNeighbor(const int id, Visit &&visit) const {
+
+        int x = id % m_cols;
+        int y = id / m_cols;
+
+        for(auto direction = 0; direction < DIRECTIONS; direction++) {
+            if(isOpen(m_graph, x, y, direction)) visit(id + OFFSET_X[direction] + OFFSET_Y[direction] * m_cols, STRAIGHT_COST);
+        }
+
+    }
+
+    // lower bound on the cost between two cells, for A*
+    int estimate(const int from, const int to) const {
+        return std::abs(from % m_cols - to % m_cols) + std::abs(from / m_cols - to / m_cols);
+    }
+
+    // passage from a cell inside the grid towards one of the four directions
+    static bool isOpen(const Graph &graph, const int x, const int y, const int direction) {
+
+        switch(direction) {
+            case 0:
+                return x > 0 && testBit(graph.getPassageRow(Graph::RIGHT, y), x - 1);
+            case 1:
+                return y > 0 && testBit(graph.getPassageRow(Graph::DOWN, y - 1), x);
+            case 2:
+                return testBit(graph.getPassageRow(Graph::RIGHT, y), x);
+            default:
+                return testBit(graph.getPassageRow(Graph::DOWN, y), x);
+        }
+
+    }
+
+private:
+    const Graph &m_graph;
+    int m_cols;
+
+};
+
+// The four straight moves plus diagonals built from the same passages. A
+// diagonal needs an open L-shaped route around one of its corners, or
+// around both when corners may not be cut (the Moving AI octile rule).
+// Costs 169 and 239 are a fixed point sqrt(2) (239 / 169 = 1.41420), so
+// routes are ranked as octile distances rank them; the search recovers the
+// exact cost from the move counts.
+template<bool CUT_CORNERS>
+class EightConnected {
+
+public:
+    static constexpr int DIRECTIONS = 8;
+    static constexpr int STRAIGHT_COST = 169;
+    static constexpr int DIAGONAL_COST = 239;
+    static constexpr int OFFSET_X[DIRECTIONS] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+    static constexpr int OFFSET_Y[DIRECTIONS] = { 0, -1, 0, 1, -1, -1, 1, 1 };
+
+    EightConnected(const Graph &graph): m_graph(graph), m_cols(graph.getCols()) {}
+
+    template<class Visit>
+    void forEachNeighbor(const int id, Visit &&visit) const {
+
+        int x = id % m_cols;
+        int y = id / m_cols;
+        bool open[4];
+
+        for(auto direction = 0; direction < 4; direction++) {
+            open[direction] = FourConnected::isOpen(m_graph, x, y, direction);
+            if(open[direction]) visit(id + OFFSET_X[direction] + OFFSET_Y[direction] * m_cols, STRAIGHT_COST);
+        }
+
+        for(auto direction = 4; direction < DIRECTIONS; direction++) {
+
+            int horizontal = OFFSET_X[direction] < 0 ? 0 : 2;
+            int vertical = OFFSET_Y[direction] < 0 ? 1 : 3;
+
+            // across the horizontal neighbour, or across the vertical one
+            bool first = open[horizontal] && FourConnected::isOpen(m_graph, x + OFFSET_X[direction], y, vertical);
+            bool second = open[vertical] && FourConnected::isOpen(m_graph, x, y + OFFSET_Y[direction], horizontal);
+
+            if(CUT_CORNERS ? first || second : first && second) visit(id + OFFSET_X[direction] + OFFSET_Y[direction] * m_cols, DIAGONAL_COST);
+
+        }
+
+    }
+
+    // octile distance: diagonals while both coordinates differ, then straight
+    int estimate(const int from, const int to) const {
+
+        int dx = std::abs(from % m_cols - to % m_cols);
+        int dy = std::abs(from / m_cols - to / m_cols);
+
+        return DIAGONAL_COST * std::min(dx, dy) + STRAIGHT_COST * (std::max(dx, dy) - std::min(dx, dy));
+
+    }
+
+private:
+    const Graph &m_graph;
+    int m_cols;
+
+};
+
+// Pointy-top hexagons in offset rows, odd rows shifted half a cell to the
+// right. Directions: east, south-east, south-west (owned), then west,
+// north-west, north-east, each the opposite of the one three before it.
+class HexConnected {
+
+public:
+    static constexpr int DIRECTIONS = 6;
+    static constexpr int STRAIGHT_COST = 1;
+    static constexpr int OFFSET_X_EVEN[DIRECTIONS] = { 1, 0, -1, -1, -1, 0 };
+    static constexpr int OFFSET_X_ODD[DIRECTIONS] = { 1, 1, 0, -1, 0, 1 };
+    static constexpr int OFFSET_Y[DIRECTIONS] = { 0, 1, 1, 0, -1, -1 };
+
+    HexConnected(const PassageGrid &grid): m_grid(grid), m_rows(grid.getRows()), m_cols(grid.getCols()) {}
+
+    template<class Visit>
+    void forEachNeighbor(const int id, Visit &&visit) const {
+
+        int neighbor;
+
+        for(auto direction = 0; direction < DIRECTIONS; direction++) {
+            if(getNeighbor(id, direction, &neighbor) && (direction < 3 ? m_grid.getPassages(id) >> direction : m_grid.getPassages(neighbor) >> (direction - 3)) & 1) visit(neighbor, STRAIGHT_COST);
+        }
+
+    }
+
+    // hex distance, from the offset rows converted to axial coordinates
+    int estimate(const int from, const int to) const {
+
+        int fromY = from / m_cols;
+        int toY = to / m_cols;
+        int dq = (from % m_cols - (fromY - (fromY & 1)) / 2) - (to % m_cols - (toY - (toY & 1)) / 2);
+        int dr = fromY - toY;
+
+        return (std::abs(dq) + std::abs(dr) + std::abs(dq + dr)) / 2;
+
+    }
+
+    // the cell in a direction, false past the edge of the map
+    bool getNeighbor(const int id, const int direction, int *neighbor) const {
+
+        int x = id % m_cols;
+        int y = id / m_cols;
+        int nx = x + (y % 2 ? OFFSET_X_ODD[direction] : OFFSET_X_EVEN[direction]);
+        int ny = y + OFFSET_Y[direction];
+
+        if(nx < 0 || ny < 0 || nx >= m_cols || ny >= m_rows) return false;
+
+        *neighbor = ny * m_cols + nx;
+        return true;
+
+    }
+
+private:
+    const PassageGrid &m_grid;
+    int m_rows;
+    int m_cols;
+
+};
+
+// Floors of 4-connected cells joined by vertical passages. Directions:
+// east, south, up (owned), then west, north, down.
+class VoxelConnected {
+
+public:
+    static constexpr int DIRECTIONS = 6;
+    static constexpr int STRAIGHT_COST = 1;
+    static constexpr int OFFSET_X[DIRECTIONS] = { 1, 0, 0, -1, 0, 0 };
+    static constexpr int OFFSET_Y[DIRECTIONS] = { 0, 1, 0, 0, -1, 0 };
+    static constexpr int OFFSET_Z[DIRECTIONS] = { 0, 0, 1, 0, 0, -1 };
+
+    VoxelConnected(const PassageGrid &grid): m_grid(grid), m_layers(grid.getLayers()), m_rows(grid.getRows()), m_cols(grid.getCols()) {}
+
+    template<class Visit>
+    void forEachNeighbor(const int id, Visit &&visit) const {
+
+        int neighbor;
+
+        for(auto direction = 0; direction < DIRECTIONS; direction++) {
+            if(getNeighbor(id, direction, &neighbor) && (direction < 3 ? m_grid.getPassages(id) >> direction : m_grid.getPassages(neighbor) >> (direction - 3)) & 1) visit(neighbor, STRAIGHT_COST);
+        }
+
+    }
+
+    int estimate(const int from, const int to) const {
+
+        int floor = m_rows * m_cols;
+
+        return std::abs(from % m_cols - to % m_cols) + std::abs(from / m_cols % m_rows - to / m_cols % m_rows) + std::abs(from / floor - to / floor);
+
+    }
+
+    bool getNeighbor(const int id, const int direction, int *neighbor) const {
+
+        int x = id % m_cols;
+        int y = id / m_cols % m_rows;
+        int z = id / m_cols / m_rows;
+        int nx = x + OFFSET_X[direction];
+        int ny = y + OFFSET_Y[direction];
+        int nz = z + OFFSET_Z[direction];
+
+        if(nx < 0 || ny < 0 || nz < 0 || nx >= m_cols || ny >= m_rows || nz >= m_layers) return false;
+
+        *neighbor = (nz * m_rows + ny) * m_cols + nx;
+        return true;
+
+    }
+
+private:
+    const PassageGrid &m_grid;
+    int m_layers;
+    int m_rows;
+    int m_cols;
+
+};
+
+#endif
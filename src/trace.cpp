@@ -0,0 +1,354 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#define TRACE_HEADER_SIZE 24
+#define TRACE_FLUSH_BYTES (64 * 1024)
+
+// the buffer is only checked at keyframes, so it needs room for a whole block of the longest
+// events (two 5 byte varints) plus the keyframe itself; a found path is checked varint by varint
+#define TRACE_BLOCK_BYTES (TRACE_KEYFRAME_INTERVAL * 10 + 64)
+
+int64_t unzigzag(const uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+TraceWriter::TraceWriter(): m_bufferSize(0), m_events(0), m_cols(0), m_popNode(0), m_popDistance(0) {}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string &path, const int rows, const int cols, const Graph::Node start, const Graph::Node target) {
+
+    close();
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_file) return false;
+
+    // only a writer that records pays for the buffer
+    m_buffer.resize(TRACE_FLUSH_BYTES + TRACE_BLOCK_BYTES);
+
+    uint32_t fields[4] = { (uint32_t) rows, (uint32_t) cols, (uint32_t) start.id, (uint32_t) target.id };
+    uint16_t version[2] = { TRACE_FILE_VERSION, 0 };
+
+    m_file.write(TRACE_FILE_MAGIC, 4);
+    m_file.write((const char*) version, sizeof(version));
+    m_file.write((const char*) fields, sizeof(fields));
+
+    m_bufferSize = 0;
+    m_events = 0;
+    m_cols = cols;
+    m_popNode = start.id;
+    m_popDistance = 0;
+
+    return (bool) m_file;
+
+}
+
+void TraceWriter::close() {
+
+    if(!m_file.is_open()) return;
+
+    flush();
+    m_file.close();
+
+}
+
+void TraceWriter::found(const vector<Graph::Node> &path) {
+
+    beginEvent();
+    writeEvent(TRACE_FOUND, 0);
+    writeVarint(path.size());
+
+    int previous = m_popNode;
+
+    for(const Graph::Node &node : path) {
+        if(m_bufferSize >= TRACE_FLUSH_BYTES) flush();
+        writeVarint(zigzag(node.id - previous));
+        previous = node.id;
+    }
+
+    flush();
+
+}
+
+void TraceWriter::exhausted() {
+
+    beginEvent();
+    writeEvent(TRACE_EXHAUSTED, 0);
+
+    flush();
+
+}
+
+size_t TraceWriter::getEventCount() const {
+    return m_events;
+}
+
+size_t TraceWriter::getMemoryUsage() const {
+    return getCapacityBytes(m_buffer);
+}
+
+// a keyframe also marks where the buffer may be flushed, keeping the per event path free of the check
+void TraceWriter::writeKeyframe() {
+
+    if(m_bufferSize >= TRACE_FLUSH_BYTES) flush();
+
+    writeVarint(TRACE_KEYFRAME);
+    writeVarint(m_events);
+    writeVarint(m_popNode);
+    writeVarint(m_popDistance);
+
+}
+
+void TraceWriter::flush() {
+
+    if(!m_file.is_open() || m_bufferSize == 0) return;
+
+    m_file.write((const char*) m_buffer.data(), m_bufferSize);
+    m_bufferSize = 0;
+
+}
+
+TracePlayer::TracePlayer(): m_eventCount(0), m_position(0), m_loadedBlock(SIZE_MAX), m_rows(0), m_cols(0), m_start(0), m_target(0), m_pathShown(false) {}
+
+// a trace cut short by a crash stays readable up to its last complete event
+bool TracePlayer::open(const std::string &path) {
+
+    std::ifstream file(path, std::ios::binary);
+    if(!file) return false;
+
+    TrackedVector<uint8_t, MEMORY_TRACE> data = TrackedVector<uint8_t, MEMORY_TRACE>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if(data.size() < TRACE_HEADER_SIZE || std::memcmp(data.data(), TRACE_FILE_MAGIC, 4) != 0) return false;
+
+    uint16_t version;
+    uint32_t fields[4];
+    std::memcpy(&version, &data[4], sizeof(version));
+    std::memcpy(fields, &data[8], sizeof(fields));
+    if(version != TRACE_FILE_VERSION || fields[0] == 0 || fields[1] == 0) return false;
+
+    m_data = std::move(data);
+    m_rows = fields[0];
+    m_cols = fields[1];
+    m_start = fields[2];
+    m_target = fields[3];
+    m_keyframes.clear();
+    m_eventCount = 0;
+    m_position = 0;
+    m_loadedBlock = SIZE_MAX;
+    m_pathShown = false;
+    m_path.clear();
+
+    size_t offset = TRACE_HEADER_SIZE;
+    int popNode = m_start;
+    int popDistance = 0;
+
+    while(offset < m_data.size()) {
+
+        size_t eventOffset = offset;
+        Event event;
+        bool keyframe;
+
+        if(!decodeEvent(&offset, &popNode, &popDistance, &event, &keyframe)) break;
+
+        if(keyframe) m_keyframes.push_back(Keyframe { eventOffset, m_eventCount, popNode, popDistance });
+        else m_eventCount++;
+
+    }
+
+    return true;
+
+}
+
+void TracePlayer::seek(const size_t position, vector<TraceChange> *changes) {
+
+    size_t target = std::min(position, m_eventCount);
+
+    while(m_position < target) {
+        loadBlock(m_position / TRACE_KEYFRAME_INTERVAL);
+        apply(m_block[m_position % TRACE_KEYFRAME_INTERVAL], true, changes);
+        m_position++;
+    }
+
+    while(m_position > target) {
+        loadBlock((m_position - 1) / TRACE_KEYFRAME_INTERVAL);
+        apply(m_block[(m_position - 1) % TRACE_KEYFRAME_INTERVAL], false, changes);
+        m_position--;
+    }
+
+}
+
+size_t TracePlayer::getEventCount() const {
+    return m_eventCount;
+}
+
+size_t TracePlayer::getPosition() const {
+    return m_position;
+}
+
+bool TracePlayer::isPathShown() const {
+    return m_pathShown;
+}
+
+const vector<Graph::Node> &TracePlayer::getPath() const {
+    return m_path;
+}
+
+int TracePlayer::getRows() const {
+    return m_rows;
+}
+
+int TracePlayer::getCols() const {
+    return m_cols;
+}
+
+Graph::Node TracePlayer::getStart() const {
+    return Graph::Node(m_start % m_cols, m_start / m_cols, m_cols);
+}
+
+Graph::Node TracePlayer::getTarget() const {
+    return Graph::Node(m_target % m_cols, m_target / m_cols, m_cols);
+}
+
+size_t TracePlayer::getMemoryUsage() const {
+    return getCapacityBytes(m_data) + getCapacityBytes(m_keyframes) + getCapacityBytes(m_block) + getCapacityBytes(m_path);
+}
+
+bool TracePlayer::readVarint(size_t *offset, uint64_t *value) const {
+
+    *value = 0;
+
+    for(int shift = 0; shift < 64; shift += 7) {
+
+        if(*offset >= m_data.size()) return false;
+
+        uint8_t byte = m_data[(*offset)++];
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+
+        if(!(byte & 0x80)) return true;
+
+    }
+
+    return false;
+
+}
+
+bool TracePlayer::decodeEvent(size_t *offset, int *popNode, int *popDistance, Event *event, bool *keyframe) {
+
+    uint64_t header;
+    uint64_t value;
+    if(!readVarint(offset, &header)) return false;
+
+    uint64_t payload = header >> 3;
+    event->type = (TraceEventType) (header & 7);
+    event->distance = 0;
+
+    if(event->type == TRACE_PUSH || event->type == TRACE_RELAX) {
+        const int directions[4] = { -1, -m_cols, 1, m_cols };
+        event->node = *popNode + (payload & 1 ? directions[(payload >> 1) & 3] : (int) unzigzag(payload >> 1));
+    } else {
+        event->node = *popNode + (int) unzigzag(payload);
+    }
+
+    *keyframe = event->type == TRACE_KEYFRAME;
+
+    switch(event->type) {
+
+        case TRACE_KEYFRAME:
+            if(!readVarint(offset, &value)) return false;
+            if(!readVarint(offset, &value)) return false;
+            *popNode = value;
+            if(!readVarint(offset, &value)) return false;
+            *popDistance = value;
+            break;
+
+        case TRACE_PUSH:
+        case TRACE_RELAX:
+        case TRACE_POP:
+            if(!readVarint(offset, &value)) return false;
+            event->distance = *popDistance + (int) unzigzag(value);
+            if(event->type == TRACE_POP) {
+                *popNode = event->node;
+                *popDistance = event->distance;
+            }
+            break;
+
+        case TRACE_FOUND: {
+            if(!readVarint(offset, &value)) return false;
+            vector<Graph::Node> path;
+            int previous = *popNode;
+            for(uint64_t i = 0; i < value; i++) {
+                uint64_t delta;
+                if(!readVarint(offset, &delta)) return false;
+                previous += (int) unzigzag(delta);
+                path.push_back(Graph::Node(previous % m_cols, previous / m_cols, m_cols));
+            }
+            m_path = std::move(path);
+            break;
+        }
+
+        case TRACE_EXHAUSTED:
+            break;
+
+        default:
+            return false;
+
+    }
+
+    return true;
+
+}
+
+void TracePlayer::loadBlock(const size_t block) {
+
+    if(m_loadedBlock == block) return;
+
+    const Keyframe &keyframe = m_keyframes[block];
+    size_t offset = keyframe.offset;
+    int popNode = keyframe.popNode;
+    int popDistance = keyframe.popDistance;
+    size_t count = std::min<size_t>(TRACE_KEYFRAME_INTERVAL, m_eventCount - keyframe.event);
+
+    m_block.clear();
+
+    while(m_block.size() < count) {
+
+        Event event;
+        bool isKeyframe;
+        decodeEvent(&offset, &popNode, &popDistance, &event, &isKeyframe);
+
+        if(!isKeyframe) m_block.push_back(event);
+
+    }
+
+    m_loadedBlock = block;
+
+}
+
+void TracePlayer::apply(const Event &event, const bool forward, vector<TraceChange> *changes) {
+
+    switch(event.type) {
+
+        case TRACE_PUSH:
+            if(forward) changes->push_back(TraceChange { event.node, Search::UNSEEN, Search::FRONTIER, event.distance });
+            else changes->push_back(TraceChange { event.node, Search::FRONTIER, Search::UNSEEN, event.distance });
+            break;
+
+        case TRACE_POP:
+            if(forward) changes->push_back(TraceChange { event.node, Search::FRONTIER, Search::VISITED, event.distance });
+            else changes->push_back(TraceChange { event.node, Search::VISITED, Search::FRONTIER, event.distance });
+            break;
+
+        case TRACE_FOUND:
+            m_pathShown = forward;
+            break;
+
+        default:
+            break;
+
+    }
+
+}
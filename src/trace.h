@@ -0,0 +1,209 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "graph.h"
+#include "memory.h"
+#include "search.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::vector;
+
+#define TRACE_FILE_MAGIC "PFVT"
+#define TRACE_FILE_VERSION 1
+#define TRACE_KEYFRAME_INTERVAL 4096
+
+// Append-only log of a search's events. After a 24 byte header (magic,
+// version, rows, cols, start, target) every event is a varint whose low 3
+// bits hold the type and the rest the node: pops as a zigzag delta to the
+// previous pop, pushes and relaxes as one of the four grid directions from
+// the node being expanded (or a zigzag delta for anything further away).
+// Distances follow as zigzag deltas to the expanded node's distance.
+// Every TRACE_KEYFRAME_INTERVAL events a keyframe restores the absolute
+// context, so a reader can start decoding at any keyframe.
+enum TraceEventType : uint8_t {
+    TRACE_PUSH,
+    TRACE_RELAX,
+    TRACE_POP,
+    TRACE_FOUND,
+    TRACE_EXHAUSTED,
+    TRACE_KEYFRAME
+};
+
+class TraceWriter {
+
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool open(const std::string &path, const int rows, const int cols, const Graph::Node start, const Graph::Node target);
+    void close();
+
+    // defined below, the search calls these once per event
+    inline void push(const int node, const int distance);
+    inline void relax(const int node, const int distance);
+    inline void pop(const int node, const int distance);
+    void found(const vector<Graph::Node> &path);
+    void exhausted();
+
+    size_t getEventCount() const;
+    size_t getMemoryUsage() const;
+
+private:
+    inline void beginEvent();
+    inline void writeEvent(const TraceEventType type, const int64_t delta);
+    inline void writeNeighborEvent(const TraceEventType type, const int delta);
+    inline void writeVarint(uint64_t value);
+    void writeKeyframe();
+    void flush();
+
+    std::ofstream m_file;
+
+    // fixed size once opened, with room for one more keyframe block past the flush threshold
+    TrackedVector<uint8_t, MEMORY_TRACE> m_buffer;
+    size_t m_bufferSize;
+    size_t m_events;
+    int m_cols;
+    int m_popNode;
+    int m_popDistance;
+
+};
+
+inline uint64_t zigzag(const int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+void TraceWriter::push(const int node, const int distance) {
+
+    beginEvent();
+    writeNeighborEvent(TRACE_PUSH, node - m_popNode);
+    writeVarint(zigzag(distance - m_popDistance));
+
+}
+
+void TraceWriter::relax(const int node, const int distance) {
+
+    beginEvent();
+    writeNeighborEvent(TRACE_RELAX, node - m_popNode);
+    writeVarint(zigzag(distance - m_popDistance));
+
+}
+
+void TraceWriter::pop(const int node, const int distance) {
+
+    beginEvent();
+    writeEvent(TRACE_POP, node - m_popNode);
+    writeVarint(zigzag(distance - m_popDistance));
+
+    m_popNode = node;
+    m_popDistance = distance;
+
+}
+
+void TraceWriter::beginEvent() {
+
+    if(m_events % TRACE_KEYFRAME_INTERVAL == 0) writeKeyframe();
+    m_events++;
+
+}
+
+void TraceWriter::writeEvent(const TraceEventType type, const int64_t delta) {
+    writeVarint(zigzag(delta) << 3 | type);
+}
+
+// a direction fits into the first byte together with the type, so most pushes take two bytes
+void TraceWriter::writeNeighborEvent(const TraceEventType type, const int delta) {
+
+    int direction = delta == -1 ? 0 : delta == -m_cols ? 1 : delta == 1 ? 2 : delta == m_cols ? 3 : -1;
+
+    if(direction >= 0) writeVarint((uint64_t) (direction << 1 | 1) << 3 | type);
+    else writeVarint(zigzag(delta) << 4 | type);
+
+}
+
+void TraceWriter::writeVarint(uint64_t value) {
+
+    uint8_t *out = &m_buffer[m_bufferSize];
+
+    while(value >= 0x80) {
+        *out++ = (uint8_t) value | 0x80;
+        value >>= 7;
+    }
+
+    *out++ = (uint8_t) value;
+    m_bufferSize = out - m_buffer.data();
+
+}
+
+// Cell state change produced while moving through a trace, in either direction.
+struct TraceChange {
+    int cell;
+    Search::CellState before;
+    Search::CellState after;
+    int distance;
+};
+
+// Scrubs through a recorded trace without re-running the search. Events
+// are decoded a keyframe block at a time; moving backwards undoes them,
+// which needs no extra data since every event has a fixed state transition.
+class TracePlayer {
+
+public:
+    TracePlayer();
+
+    bool open(const std::string &path);
+
+    // moves to the position after the first position events
+    void seek(const size_t position, vector<TraceChange> *changes);
+
+    size_t getEventCount() const;
+    size_t getPosition() const;
+    bool isPathShown() const;
+    const vector<Graph::Node> &getPath() const;
+    int getRows() const;
+    int getCols() const;
+    Graph::Node getStart() const;
+    Graph::Node getTarget() const;
+    size_t getMemoryUsage() const;
+
+private:
+    struct Keyframe {
+        size_t offset;
+        size_t event;
+        int popNode;
+        int popDistance;
+    };
+
+    struct Event {
+        TraceEventType type;
+        int node;
+        int distance;
+    };
+
+    bool readVarint(size_t *offset, uint64_t *value) const;
+    bool decodeEvent(size_t *offset, int *popNode, int *popDistance, Event *event, bool *keyframe);
+    void loadBlock(const size_t block);
+    void apply(const Event &event, const bool forward, vector<TraceChange> *changes);
+
+    TrackedVector<uint8_t, MEMORY_TRACE> m_data;
+    TrackedVector<Keyframe, MEMORY_TRACE> m_keyframes;
+    size_t m_eventCount;
+    size_t m_position;
+
+    size_t m_loadedBlock;
+    TrackedVector<Event, MEMORY_TRACE> m_block;
+
+    int m_rows;
+    int m_cols;
+    int m_start;
+    int m_target;
+    bool m_pathShown;
+    vector<Graph::Node> m_path;
+
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "walls.h"
+
+#include <algorithm>
+
+Walls::Walls(const Graph &graph): m_rows(0), m_cols(0) {
+    rebuild(graph);
+}
+
+void Walls::rebuild(const Graph &graph) {
+
+    m_rows = graph.getRows();
+    m_cols = graph.getCols();
+
+    m_horizontal.assign(m_rows + 1, SegmentList());
+    m_vertical.assign(m_cols + 1, SegmentList());
+    m_dirtyHorizontal.assign(m_rows + 1, true);
+    m_dirtyVertical.assign(m_cols + 1, true);
+
+}
+
+void Walls::invalidate(const Graph::Node node) {
+
+    if(node.x < 0 || node.y < 0 || node.x >= m_cols || node.y >= m_rows) return;
+
+    // a cell only touches the four grid lines surrounding it
+    m_dirtyHorizontal[node.y] = true;
+    m_dirtyHorizontal[node.y + 1] = true;
+    m_dirtyVertical[node.x] = true;
+    m_dirtyVertical[node.x + 1] = true;
+
+}
+
+// marks every grid line touching the cells [x0, x1) x [y0, y1)
+void Walls::invalidateRect(const int x0, const int y0, const int x1, const int y1) {
+
+    for(auto y = std::max(y0, 0); y <= std::min(y1, m_rows); y++) m_dirtyHorizontal[y] = true;
+    for(auto x = std::max(x0, 0); x <= std::min(x1, m_cols); x++) m_dirtyVertical[x] = true;
+
+}
+
+void Walls::update(const Graph &graph) {
+    update(graph, 0, graph.getRows(), 0, graph.getCols());
+}
+
+void Walls::update(const Graph &graph, const int firstLineY, const int lastLineY, const int firstLineX, const int lastLineX) {
+
+    if(graph.getRows() != m_rows || graph.getCols() != m_cols) rebuild(graph);
+
+    for(auto y = std::max(firstLineY, 1); y <= std::min(lastLineY, m_rows - 1); y++) {
+        if(!m_dirtyHorizontal[y]) continue;
+        rebuildHorizontalLine(graph, y);
+        m_dirtyHorizontal[y] = false;
+    }
+
+    for(auto x = std::max(firstLineX, 1); x <= std::min(lastLineX, m_cols - 1); x++) {
+        if(!m_dirtyVertical[x]) continue;
+        rebuildVerticalLine(graph, x);
+        m_dirtyVertical[x] = false;
+    }
+
+}
+
+const TrackedVector<Walls::SegmentList, MEMORY_RENDERING> &Walls::getHorizontalRuns() const {
+    return m_horizontal;
+}
+
+const TrackedVector<Walls::SegmentList, MEMORY_RENDERING> &Walls::getVerticalRuns() const {
+    return m_vertical;
+}
+
+size_t Walls::segmentCount() const {
+
+    size_t count = 0;
+
+    for(const auto &line : m_horizontal) count += line.size();
+    for(const auto &line : m_vertical) count += line.size();
+
+    return count;
+
+}
+
+size_t Walls::getMemoryUsage() const {
+
+    size_t bytes = getCapacityBytes(m_horizontal) + getCapacityBytes(m_vertical) + getCapacityBytes(m_dirtyHorizontal) + getCapacityBytes(m_dirtyVertical);
+
+    for(const auto &line : m_horizontal) bytes += getCapacityBytes(line);
+    for(const auto &line : m_vertical) bytes += getCapacityBytes(line);
+
+    return bytes;
+
+}
+
+void Walls::rebuildHorizontalLine(const Graph &graph, const int y) {
+
+    SegmentList &runs = m_horizontal[y];
+    runs.clear();
+
+    int runStart = -1;
+
+    for(auto x = 0; x < m_cols; x++) {
+
+        bool isWall = !graph.hasEdge(Graph::Node(x, y - 1, m_cols), Graph::Node(x, y, m_cols));
+
+        if(isWall && runStart < 0) runStart = x;
+        if(!isWall && runStart >= 0) {
+            runs.push_back(Segment{ runStart, y, x, y });
+            runStart = -1;
+        }
+
+    }
+
+    if(runStart >= 0) runs.push_back(Segment{ runStart, y, m_cols, y });
+
+}
+
+void Walls::rebuildVerticalLine(const Graph &graph, const int x) {
+
+    SegmentList &runs = m_vertical[x];
+    runs.clear();
+
+    int runStart = -1;
+
+    for(auto y = 0; y < m_rows; y++) {
+
+        bool isWall = !graph.hasEdge(Graph::Node(x - 1, y, m_cols), Graph::Node(x, y, m_cols));
+
+        if(isWall && runStart < 0) runStart = y;
+        if(!isWall && runStart >= 0) {
+            runs.push_back(Segment{ x, runStart, x, y });
+            runStart = -1;
+        }
+
+    }
+
+    if(runStart >= 0) runs.push_back(Segment{ x, runStart, x, m_rows });
+
+}
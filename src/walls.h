@@ -0,0 +1,55 @@
+#ifndef WALLS_H
+#define WALLS_H
+
+#include "graph.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+// Maximal horizontal and vertical wall runs extracted from a Graph.
+// Coordinates are in grid-line units: a horizontal run on line y separates
+// row y - 1 from row y, a vertical run on line x separates column x - 1 from
+// column x. The outer border is not included. Lines are refreshed lazily, so
+// only the lines that are actually looked at pay for an edit or a resize.
+class Walls {
+
+public:
+    struct Segment {
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    typedef TrackedVector<Segment, MEMORY_RENDERING> SegmentList;
+
+    Walls(const Graph &graph);
+    void rebuild(const Graph &graph);
+    void invalidate(const Graph::Node node);
+    void invalidateRect(const int x0, const int y0, const int x1, const int y1);
+    void update(const Graph &graph);
+    void update(const Graph &graph, const int firstLineY, const int lastLineY, const int firstLineX, const int lastLineX);
+
+    const TrackedVector<SegmentList, MEMORY_RENDERING> &getHorizontalRuns() const;
+    const TrackedVector<SegmentList, MEMORY_RENDERING> &getVerticalRuns() const;
+    size_t segmentCount() const;
+    size_t getMemoryUsage() const;
+
+private:
+    void rebuildHorizontalLine(const Graph &graph, const int y);
+    void rebuildVerticalLine(const Graph &graph, const int x);
+
+    int m_rows;
+    int m_cols;
+
+    TrackedVector<SegmentList, MEMORY_RENDERING> m_horizontal;
+    TrackedVector<SegmentList, MEMORY_RENDERING> m_vertical;
+    TrackedVector<bool, MEMORY_RENDERING> m_dirtyHorizontal;
+    TrackedVector<bool, MEMORY_RENDERING> m_dirtyVertical;
+
+};
+
+#endif